@@ -80,6 +80,11 @@ def _particle(subbranch):
             for c in ['x','y','z','t']
         }, with_name = 'Vector4D'),
     })
+    try:
+        d['weight'] = subbranch('weight')
+    except KeyError:
+        # particles written before the track weight was stored
+        d['weight'] = ak.ones_like(d['valid'], dtype=np.float64)
     return ak.zip(d, with_name='Particle')
 
 
@@ -98,6 +103,125 @@ ak.behavior[ak.count, "Particle"] = particle_count
 ak.behavior[ak.num, "Particle"] = particle_count
 
 
+def _run_header(f):
+    """Load the run header from the opened file
+
+    We check the version of the file against this module and
+    warn if the file is newer than us.
+
+    Parameters
+    ----------
+    f : uproot.ReadOnlyDirectory
+        opened file to read the run header from
+
+    Returns
+    -------
+    namespace
+        the run header members as attributes
+    """
+    run_header = SimpleNamespace(**f['run'].members)
+    try:
+        file_version_tuple = (
+            run_header.version_major_,
+            run_header.version_minor_,
+            run_header.version_patch_
+        ) 
+    except KeyError:
+        # no version_* entries in the run header means
+        # the file was written before v0.3.0 so we just
+        # call it v0.2.0
+        file_version_tuple = (0,2,0)
+
+    if file_version_tuple > __version_tuple__:
+        file_version = '.'.join(map(str,file_version_tuple))
+        warnings.warn(
+            f"The loading module version {__version__} is older than "
+            f"the version producing the data file being loaded {file_version}. "
+            "This may break the loading procedure - please update this module."
+        )
+
+    # divide depth by tungsten radiation length to get a nice
+    # labeling number for the sample
+    run_header.depth_x0 = round(run_header.depth_/3.50259,1)
+    if hasattr(run_header, 'weight_sum_'):
+        run_header.eot, run_header.eot_uncertainty = _eot(
+            run_header.tries_,
+            run_header.accepted_,
+            run_header.weight_sum_,
+            run_header.weight_sq_sum_
+        )
+    return run_header
+
+
+def _eot(tries, accepted, weight_sum, weight_sq_sum):
+    """Calculate the equivalent EoT and its uncertainty from the weight statistics
+
+    The average bias is the number of accepted events divided by the sum of their
+    weights and the EoT is the number of tries scaled by this average bias. The
+    relative uncertainty on the EoT is the relative uncertainty on the mean weight.
+    """
+    if accepted == 0 or weight_sum <= 0:
+        return 0., 0.
+    mean = weight_sum/accepted
+    variance = max(0., weight_sq_sum/accepted - mean**2)
+    eot = tries/mean
+    return eot, eot*np.sqrt(variance/accepted)/mean
+
+
+def eot(fps):
+    """Calculate the equivalent EoT of a set of files from only their run headers
+
+    Newer run headers (class version 2 and above) hold the running statistics of the
+    event weights so we do not need to read any events.
+
+    Parameters
+    ----------
+    fps : list[str | pathlib.Path]
+        file paths to the files of the sample
+
+    Returns
+    -------
+    (float, float)
+        the EoT and its uncertainty
+    """
+    totals = np.zeros(4)
+    for fp in fps:
+        with uproot.open(fp) as f:
+            m = f['run'].members
+            totals += [m['tries_'], m['accepted_'], m['weight_sum_'], m['weight_sq_sum_']]
+    return _eot(*totals)
+
+
+# names of the derived kinematic branches written by dimuon-simulate --derived
+DERIVED = [
+    'pair_mass', 'opening_angle',
+    'mu_plus_theta', 'mu_plus_phi', 'mu_minus_theta', 'mu_minus_phi',
+    'mu_plus_ecal_r', 'mu_minus_ecal_r'
+]
+
+
+def derived(fp):
+    """Load only the derived kinematic branches of the events
+
+    This is much faster than loadup when only the muon kinematics are
+    needed since the particles are not read. The values are NaN for events
+    without a muon-conversion or when a muon misses the ECal scoring plane.
+
+    Parameters
+    ----------
+    fp : str, pathlib.Path
+        file path to file written with dimuon-simulate --derived
+
+    Returns
+    -------
+    ak.Array
+        record array with the weight and the derived kinematics of each event
+    """
+
+    with uproot.open(fp) as f:
+        return f['events'].arrays(['weight']+DERIVED)
+
+
 def loadup(fp):
     """Main loading function for dimuon analysis
 
@@ -117,27 +241,7 @@ def loadup(fp):
     """
 
     with uproot.open(fp) as f:
-        run_header = SimpleNamespace(**f['run'].members)
-        try:
-            file_version_tuple = (
-                run_header.version_major_,
-                run_header.version_minor_,
-                run_header.version_patch_
-            ) 
-        except KeyError:
-            # no version_* entries in the run header means
-            # the file was written before v0.3.0 so we just
-            # call it v0.2.0
-            file_version_tuple = (0,2,0)
-
-        if file_version_tuple > __version_tuple__:
-            file_version = '.'.join(map(str,file_version_tuple))
-            warnings.warn(
-                f"The loading module version {__version__} is older than "
-                f"the version producing the data file being loaded {file_version}. "
-                "This may break the loading procedure - please update this module."
-            )
-
+        run_header = _run_header(f)
         event_tree = f['events']
         d = {
             name : _particle(_create_subbranch(event_tree, name))
@@ -150,9 +254,68 @@ def loadup(fp):
             'extra' : _particle(_create_subbranch(event_tree, 'extra', single=False)),
             'ecal' : _particle(_create_subbranch(event_tree, 'ecal', single=False))
         })
+        # derived kinematics are only written if requested
+        d.update({
+            name : event_tree[name].array()
+            for name in DERIVED if name in event_tree
+        })
         events = ak.zip(d, depth_limit=1)
-        run_header.eot =  ak.count(events.weight)/ak.sum(events.weight)*run_header.tries_
-        # divide depth by tungsten radiation length to get a nice
-        # labeling number for the sample
-        run_header.depth_x0 = round(run_header.depth_/3.50259,1)
+        if not hasattr(run_header, 'eot'):
+            # files without the weight statistics in the run header
+            run_header.eot =  ak.count(events.weight)/ak.sum(events.weight)*run_header.tries_
         return run_header, events
+
+
+def select(fp, key, low = -np.inf, high = np.inf):
+    """Select the entries of the events with a key in the range [low, high)
+
+    This uses the sorted indices written by dimuon-index so only the matching
+    part of the index needs to be searched and none of the events are read.
+
+    Parameters
+    ----------
+    fp : str, pathlib.Path
+        file path to indexed file
+    key : str
+        name of key to select on (e.g. 'mu_min_energy' or 'pair_mass')
+    low : float, optional
+        lower (inclusive) bound on the key
+    high : float, optional
+        upper (exclusive) bound on the key
+
+    Returns
+    -------
+    np.ndarray
+        sorted entry numbers of the selected events
+    """
+    with uproot.open(fp) as f:
+        name = f'index_{key}'
+        if name not in f:
+            raise KeyError(f'{fp} does not have an index for {key}, has dimuon-index been run on it?')
+        index = f[name].arrays(['value', 'entry'], library='np')
+    begin, end = np.searchsorted(index['value'], [low, high], side='left')
+    return np.sort(index['entry'][begin:end])
+
+
+def entry_ranges(entries):
+    """Group sorted entry numbers into contiguous ranges
+
+    The ranges can be given to uproot as entry_start and entry_stop
+    so that only the clusters holding selected entries are read.
+
+    Parameters
+    ----------
+    entries : np.ndarray
+        sorted entry numbers (e.g. from select)
+
+    Returns
+    -------
+    list[(int, int)]
+        start (inclusive) and stop (exclusive) of each range
+    """
+    if len(entries) == 0:
+        return []
+    breaks = np.flatnonzero(np.diff(entries) != 1)+1
+    starts = np.concatenate(([0], breaks))
+    stops = np.concatenate((breaks, [len(entries)]))
+    return [(int(entries[b]), int(entries[e-1])+1) for b, e in zip(starts, stops)]
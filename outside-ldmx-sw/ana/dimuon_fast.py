@@ -0,0 +1,176 @@
+"""fast loading of dimuon events through the compiled ColumnReader
+
+The ColumnReader from the DimuonSimulation library reads the split leaves
+of the particle branches (e.g. mu_plus.px) straight into contiguous columns
+in C++, reading the next block of entries in the background.
+Here we view those columns with NumPy without copying them again
+and assemble them into the same awkward form that dimuon.loadup provides.
+Every NumPy view holds a reference to its block, so the memory stays
+valid as long as any array (or sub-array) built from the block is alive.
+
+The library is found using the DIMUON_LIB environment variable, falling
+back to the build directory of this project.
+
+Examples
+========
+
+    import dimuon_fast
+    run_header, events = dimuon_fast.loadup(fp)
+
+    for events in dimuon_fast.iterate(fp):
+        # one block of events at a time
+        ...
+
+"""
+
+
+import os
+import pathlib
+
+
+import awkward as ak
+import numpy as np
+import uproot
+import ROOT
+
+
+import dimuon
+
+
+_lib = os.environ.get(
+    'DIMUON_LIB',
+    str(pathlib.Path(__file__).resolve().parent.parent / 'build' / 'libDimuonSimulation.so')
+)
+# the reader reads ahead in a background thread, which needs thread safety
+# enabled before ROOT objects are created
+ROOT.EnableThreadSafety()
+if ROOT.gSystem.Load(_lib) < 0:
+    raise ImportError(f'Unable to load the DimuonSimulation library from {_lib}')
+# the caller owns the blocks returned by next
+ROOT.ColumnReader.next.__creates__ = True
+
+
+_INTEGER_MEMBERS = ['valid', 'track_id', 'pdg_id', 'parent_id']
+
+
+class _BlockView:
+    """Expose a column of a block to NumPy while holding the block
+
+    NumPy keeps the object it got the array interface from as the base
+    of the array (and of any views of that array), so each array viewing
+    a column keeps the whole block alive.
+    """
+
+    def __init__(self, column, block):
+        self.__array_interface__ = np.asarray(column).__array_interface__
+        self._block = block
+
+
+def _view(column, block):
+    """View a column of the block with NumPy without copying"""
+    return np.asarray(_BlockView(column, block))
+
+
+def _create_subbranch(block, name):
+    """Create a local Callable which views the columns of a branch
+
+    Parameters
+    ----------
+    block : ROOT.ColumnReader.Block
+        block of columns we are viewing
+    name : str
+        branch we want to get the member columns for
+
+    Returns
+    -------
+    Callable
+        a function that can be called with a member name to view the column
+        of that member
+    """
+    def _subbranch(member_name):
+        if member_name == 'valid':
+            # small enough that we just convert the integers
+            return _view(block.integer[f'{name}.{member_name}'], block).astype(bool)
+        if member_name in _INTEGER_MEMBERS:
+            return _view(block.integer[f'{name}.{member_name}'], block)
+        return _view(block.real[f'{name}.{member_name}'], block)
+    return _subbranch
+
+
+def _collection(block, name):
+    """View a particle collection as a jagged array using its offsets"""
+    flat = dimuon._particle(_create_subbranch(block, name))
+    offsets = ak.index.Index64(_view(block.offsets[name], block))
+    return ak.Array(ak.contents.ListOffsetArray(offsets, flat.layout))
+
+
+def _events(block):
+    """Assemble the awkward array of events from a block
+
+    The block is kept alive as long as the returned array,
+    or any array taken from it, is alive since they view its memory.
+    """
+    d = {
+        name : dimuon._particle(_create_subbranch(block, name))
+        for name in [
+            'incident', 'parent', 'mu_plus', 'mu_minus'
+        ]
+    }
+    d.update({
+        'weight' : _view(block.real['weight'], block),
+        'extra' : _collection(block, 'extra'),
+        'ecal' : _collection(block, 'ecal')
+    })
+    return ak.zip(d, depth_limit=1)
+
+
+def iterate(fp, block_size = 0):
+    """Iterate over the events in blocks
+
+    Parameters
+    ----------
+    fp : str, pathlib.Path
+        file path to file we want to read
+    block_size : int, optional
+        number of entries per block, default is to follow the clusters of the file
+
+    Yields
+    ------
+    ak.Array
+        awkward array of the events in each block
+    """
+    reader = ROOT.ColumnReader(str(fp), block_size)
+    while True:
+        block = reader.next()
+        if not block:
+            return
+        yield _events(block)
+
+
+def loadup(fp):
+    """Main loading function for dimuon analysis
+
+    Equivalent to dimuon.loadup, but reading all of the events
+    as a single block through the ColumnReader.
+
+    Parameters
+    ----------
+    fp : str, pathlib.Path
+        file path to file we want to open and read
+
+    Returns
+    -------
+    (namespace, ak.Array)
+        a tuple of the run header information and the awkward array of events
+    """
+
+    with uproot.open(fp) as f:
+        run_header = dimuon._run_header(f)
+        n_entries = f['events'].num_entries
+
+    events = next(iterate(fp, block_size = n_entries), None)
+    if events is None:
+        raise ValueError(f'{fp} does not have any events')
+    if not hasattr(run_header, 'eot'):
+        run_header.eot = ak.count(events.weight)/ak.sum(events.weight)*run_header.tries_
+    return run_header, events
@@ -0,0 +1,243 @@
+/**
+ * @file ana.cxx
+ * definition of dimuon-ana executable
+ */
+
+#include <iostream>
+#include <memory>
+
+#include "ROOT/RDataFrame.hxx"
+#include "TFile.h"
+#include "TParameter.h"
+
+#include "Kinematics.h"
+#include "RunHeader.h"
+
+/**
+ * print out how to use dimuon-ana
+ */
+void usage() {
+  std::cout <<
+    "USAGE:\n"
+    "  dimuon-ana [options] OUTPUT INPUT [INPUT ...]\n"
+    "\n"
+    "Fill the standard histograms of derived quantities from dimuon-simulate output files.\n"
+    "The events are streamed through in parallel so only the histograms are held in memory.\n"
+    "All histograms are filled with the event weight.\n"
+    "\n"
+    "ARGUMENTS\n"
+    "  OUTPUT       : output ROOT file to write histograms and EoT to\n"
+    "  INPUT        : one or more output files of dimuon-simulate\n"
+    "\n"
+    "OPTIONS\n"
+    "  -h,--help    : produce this help and exit\n"
+    "  -j,--threads : number of threads to use, default is 0 which means all available cores\n"
+    << std::flush;
+}
+
+/// a particle species we separate the leakage into
+struct Species {
+  /// name to use in histogram names
+  std::string name;
+  /// PDG ID of particles in this species, 0 means any particle not in another species
+  int pdg;
+};
+
+/// the species we categorize leakage into
+static const std::vector<Species> LEAKAGE_SPECIES = {
+  {"photon", 22},
+  {"electron", 11},
+  {"positron", -11},
+  {"neutron", 2112},
+  {"other", 0}
+};
+
+/// check if the input particle is in the input species
+static bool in_species(const Particle& p, const Species& species) {
+  if (species.pdg != 0) return p.pdg() == species.pdg;
+  for (const Species& s : LEAKAGE_SPECIES) {
+    if (s.pdg != 0 and p.pdg() == s.pdg) return false;
+  }
+  return true;
+}
+
+/**
+ * definition of dimuon-ana
+ *
+ * We first merge the run headers to get the EoT and the beam energy
+ * for the binning, then book all of the histograms so that they can be
+ * filled in a single (parallel) pass over the events.
+ */
+int main(int argc, char* argv[]) try {
+  unsigned int n_threads{0};
+  std::vector<std::string> positional;
+  for (int i_arg{1}; i_arg < argc; ++i_arg) {
+    std::string arg{argv[i_arg]};
+    if (arg == "-h" or arg == "--help") {
+      usage();
+      return 0;
+    } else if (arg == "-j" or arg == "--threads") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      n_threads = std::stoi(argv[++i_arg]);
+    } else if (arg[0] == '-') {
+      std::cerr << arg << " is not a recognized option" << std::endl;
+      return 1;
+    } else {
+      positional.push_back(arg);
+    }
+  }
+
+  if (positional.size() < 2) {
+    usage();
+    std::cerr << "\nOUTPUT and at least one INPUT are required!\n" << std::flush;
+    return 1;
+  }
+
+  std::string output_filename{positional[0]};
+  std::vector<std::string> inputs{positional.begin()+1, positional.end()};
+
+  std::unique_ptr<RunHeader> run_header;
+  for (const std::string& input : inputs) {
+    TFile f{input.c_str()};
+    if (not f.IsOpen()) {
+      throw std::runtime_error("Unable to open '"+input+"'.");
+    }
+    std::unique_ptr<RunHeader> rh{f.Get<RunHeader>("run")};
+    if (not rh) {
+      throw std::runtime_error("'"+input+"' does not have a run header.");
+    }
+    if (run_header) run_header->merge(*rh);
+    else run_header = std::move(rh);
+  }
+  double tries = run_header->tries();
+  double max_energy = run_header->beam()*1000.;
+
+  ROOT::EnableImplicitMT(n_threads);
+  ROOT::RDataFrame df("events", inputs);
+
+  auto n_events = df.Count();
+  auto weight_sum = df.Sum<double>("weight");
+
+  std::vector<ROOT::RDF::RResultPtr<TH1D>> h1;
+  std::vector<ROOT::RDF::RResultPtr<TH2D>> h2;
+
+  /**
+   * leakage out of the back of the target
+   *
+   * We fill vector columns so we need a weight for each entry as well.
+   * Unbiased runs may have used Russian roulette and splitting on the
+   * low-energy shower, so the particles are counted with their own track
+   * weights. Biased runs keep using the event weight since the track weights
+   * also hold the biasing factors which are already in the event weight.
+   * A bias function scaled by --bias 1 still biases away from its reference energy.
+   */
+  const bool use_track_weights{run_header->bias() == 1. and run_header->brem_bias() == 1.
+    and run_header->bias_function().empty()};
+  ROOT::RDF::RNode leakage{df};
+  for (const Species& species : LEAKAGE_SPECIES) {
+    leakage = leakage
+      .Define(species.name+"_energy", [species](const ROOT::RVec<Particle>& extra) {
+          ROOT::RVecD energies;
+          for (const Particle& p : extra) {
+            if (in_species(p, species)) energies.push_back(p.total_energy());
+          }
+          return energies;
+        }, {"extra"})
+      .Define(species.name+"_weight", [species, use_track_weights](const ROOT::RVec<Particle>& extra, double weight) {
+          ROOT::RVecD weights;
+          for (const Particle& p : extra) {
+            if (in_species(p, species)) weights.push_back(use_track_weights ? p.track_weight() : weight);
+          }
+          return weights;
+        }, {"extra", "weight"});
+    h1.push_back(leakage.Histo1D<ROOT::RVecD, ROOT::RVecD>(
+          {("leak_"+species.name+"_energy").c_str(),
+           (";"+species.name+" Energy Leaving Target [MeV];Weighted Particles").c_str(),
+           200, 0., max_energy},
+          species.name+"_energy", species.name+"_weight"));
+  }
+
+  /**
+   * muon kinematics require a muon-conversion to have happened
+   */
+  auto plane_position = [](const Particle& mu, const ROOT::RVec<Particle>& ecal) {
+    const Particle* hit{kinematics::find_hit(ecal, mu.id())};
+    if (hit == nullptr) return ROOT::RVecD{};
+    auto position{hit->position()};
+    return ROOT::RVecD{position.X(), position.Y()};
+  };
+  auto muons = df
+    .Filter([](const Particle& mu_plus, const Particle& mu_minus) {
+        return mu_plus.is_valid() and mu_minus.is_valid();
+      }, {"mu_plus", "mu_minus"}, "muon-conversion")
+    .Define("pair_mass", kinematics::pair_mass, {"mu_plus", "mu_minus"})
+    .Define("opening_angle", kinematics::opening_angle, {"mu_plus", "mu_minus"})
+    .Define("mu_plus_energy", [](const Particle& mu) { return mu.total_energy(); }, {"mu_plus"})
+    .Define("mu_minus_energy", [](const Particle& mu) { return mu.total_energy(); }, {"mu_minus"})
+    .Define("mu_plus_ecal", plane_position, {"mu_plus", "ecal"})
+    .Define("mu_minus_ecal", plane_position, {"mu_minus", "ecal"});
+
+  h1.push_back(muons.Histo1D<double, double>(
+        {"pair_mass", ";Pair Invariant Mass [MeV];Weighted Events", 200, 0., max_energy/2},
+        "pair_mass", "weight"));
+  h1.push_back(muons.Histo1D<double, double>(
+        {"opening_angle", ";Opening Angle [rad];Weighted Events", 200, 0., 1.},
+        "opening_angle", "weight"));
+  h1.push_back(muons.Histo1D<double, double>(
+        {"mu_plus_energy", ";#mu^{+} Energy [MeV];Weighted Events", 200, 0., max_energy},
+        "mu_plus_energy", "weight"));
+  h1.push_back(muons.Histo1D<double, double>(
+        {"mu_minus_energy", ";#mu^{-} Energy [MeV];Weighted Events", 200, 0., max_energy},
+        "mu_minus_energy", "weight"));
+  for (const std::string& mu : {"mu_plus", "mu_minus"}) {
+    auto at_ecal = muons
+      .Filter([](const ROOT::RVecD& hit) { return not hit.empty(); }, {mu+"_ecal"}, mu+" at ECal")
+      .Define(mu+"_ecal_x", [](const ROOT::RVecD& hit) { return hit[0]; }, {mu+"_ecal"})
+      .Define(mu+"_ecal_y", [](const ROOT::RVecD& hit) { return hit[1]; }, {mu+"_ecal"});
+    h2.push_back(at_ecal.Histo2D<double, double, double>(
+          {(mu+"_ecal_position").c_str(), ";x at ECal Scoring Plane [mm];y at ECal Scoring Plane [mm]",
+           100, -500., 500., 100, -500., 500.},
+          mu+"_ecal_x", mu+"_ecal_y", "weight"));
+  }
+
+  /**
+   * the event loop is run here when we first access a result
+   *
+   * Files written before the run header held the weight statistics
+   * need the EoT to be calculated from the weights of the events.
+   */
+  double eot{run_header->eot()}, eot_uncertainty{run_header->eot_uncertainty()};
+  if (run_header->selected() != static_cast<Long64_t>(*n_events)) {
+    eot = (*n_events > 0 ? *n_events / *weight_sum * tries : 0.);
+    eot_uncertainty = 0.;
+  }
+  std::cout
+    << "Parameter         : Value\n"
+    << "Num Inputs        : " << inputs.size() << "\n"
+    << "Sim EoT           : " << tries << "\n"
+    << "Num Events        : " << *n_events << "\n"
+    << "Weight Sum        : " << *weight_sum << "\n"
+    << "EoT               : " << eot << " +- " << eot_uncertainty << "\n"
+    << "Destination       : " << output_filename << "\n"
+    << std::flush;
+
+  TFile out{output_filename.c_str(), "RECREATE"};
+  if (not out.IsOpen()) {
+    std::cerr << "File '" << output_filename << "' was not able to be opened." << std::endl;
+    return 2;
+  }
+  for (auto& h : h1) h->Write();
+  for (auto& h : h2) h->Write();
+  TParameter<double>("eot", eot).Write();
+  TParameter<double>("eot_uncertainty", eot_uncertainty).Write();
+  TParameter<double>("tries", tries).Write();
+  out.Close();
+
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "ERROR: " << e.what() << std::endl;
+  return 127;
+}
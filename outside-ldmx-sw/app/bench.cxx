@@ -0,0 +1,312 @@
+/**
+ * @file bench.cxx
+ * definition of dimuon-bench executable
+ */
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <regex>
+#include <sstream>
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include "RunHeader.h"
+#include "Subprocess.h"
+#include "Version.h"
+
+/**
+ * print out how to use dimuon-bench
+ */
+void usage() {
+  std::cout <<
+    "USAGE:\n"
+    "  dimuon-bench [options]\n"
+    "\n"
+    "Measure the throughput of dimuon-simulate over a fixed matrix of configurations.\n"
+    "  beam   : electron, photon\n"
+    "  depth  : 0.1X0, 1X0, 10X0 of tungsten\n"
+    "  bias   : unbiased, 1e4\n"
+    "  filter : unfiltered, 1000 MeV\n"
+    "Each configuration is run once without any events to measure the initialization time\n"
+    "and then again with the requested number of events. The results are written as JSON\n"
+    "with one configuration per line so they can be compared to a stored baseline.\n"
+    "\n"
+    "OPTIONS\n"
+    "  -h,--help      : produce this help and exit\n"
+    "  -n,--events    : number of events to simulate in each configuration, default 1000\n"
+    "  -o,--output    : file to write the JSON results to, default is the terminal\n"
+    "  --baseline     : JSON results of a previous dimuon-bench to compare against\n"
+    "  --only         : only run configurations whose name contains the input string\n"
+    "  --simulate     : path to dimuon-simulate, default is the one next to dimuon-bench\n"
+    "  --keep         : directory to keep the output of each configuration in\n"
+    "                   default is to delete it after it is measured\n"
+    << std::flush;
+}
+
+/// radiation length of tungsten [mm]
+static const double TUNGSTEN_X0 = 3.50259;
+
+/// a single configuration of dimuon-simulate to benchmark
+struct Configuration {
+  /// name of configuration in the results
+  std::string name;
+  /// arguments to dimuon-simulate besides the number of events and output
+  std::vector<std::string> args;
+};
+
+/// the measurements of a single configuration
+struct Measurement {
+  /// wall time to initialize and close a run without events [s]
+  double init_time;
+  /// simulated events per second after initialization
+  double events_per_second;
+  /// accepted (written) events per second after initialization
+  double accepted_per_second;
+  /// peak resident set size [MB]
+  double peak_rss;
+  /// output file size per accepted event [B]
+  double bytes_per_event;
+};
+
+/**
+ * the fixed matrix of configurations
+ *
+ * The names are used as the keys in the results so they should not
+ * be changed or else we lose comparisons to older baselines.
+ */
+static std::vector<Configuration> matrix() {
+  std::vector<Configuration> configs;
+  for (const std::string& beam : {"electron", "photon"}) {
+    for (const double depth_x0 : {0.1, 1., 10.}) {
+      for (const bool biased : {false, true}) {
+        for (const bool filtered : {false, true}) {
+          std::stringstream name;
+          name << beam << "_" << depth_x0 << "X0_"
+            << (biased ? "bias1e4" : "unbiased") << "_"
+            << (filtered ? "filter1000" : "unfiltered");
+          Configuration config{name.str(), {"--depth", std::to_string(depth_x0*TUNGSTEN_X0)}};
+          if (beam == "photon") config.args.push_back("--photons");
+          if (biased) config.args.insert(config.args.end(), {"--bias", "1e4"});
+          if (filtered) config.args.insert(config.args.end(), {"--filter", "1000"});
+          configs.push_back(config);
+        }
+      }
+    }
+  }
+  return configs;
+}
+
+/**
+ * run dimuon-simulate with the input arguments, returning its wall time and result
+ */
+static std::pair<double, subprocess::Result> timed_run(const std::vector<std::string>& args, const std::string& log) {
+  auto start{std::chrono::steady_clock::now()};
+  subprocess::Result result{subprocess::run(args, log)};
+  std::chrono::duration<double> wall{std::chrono::steady_clock::now()-start};
+  if (result.exit_code != 0) {
+    throw std::runtime_error("'"+args[0]+"' exited with "+std::to_string(result.exit_code)
+        +", see '"+log+"' for its output.");
+  }
+  return {wall.count(), result};
+}
+
+/**
+ * measure a single configuration
+ */
+static Measurement measure(const std::string& simulate, const Configuration& config,
+    int num_events, const std::filesystem::path& dir) {
+  auto command = [&](int n, const std::filesystem::path& output) {
+    std::vector<std::string> args{simulate};
+    args.insert(args.end(), config.args.begin(), config.args.end());
+    args.push_back(std::to_string(n));
+    args.push_back(output.string());
+    return args;
+  };
+  auto init_output{dir / (config.name+"_init.root")}, output{dir / (config.name+".root")};
+  auto [init_time, init_result] = timed_run(command(0, init_output), (dir / (config.name+"_init.log")).string());
+  auto [run_time, run_result] = timed_run(command(num_events, output), (dir / (config.name+".log")).string());
+
+  Long64_t accepted{0};
+  {
+    TFile f{output.c_str()};
+    std::unique_ptr<RunHeader> rh{f.Get<RunHeader>("run")};
+    if (not rh) {
+      throw std::runtime_error("'"+output.string()+"' does not have a run header.");
+    }
+    accepted = rh->selected();
+  }
+  double event_time{std::max(run_time-init_time, 1e-9)};
+  double event_bytes = std::filesystem::file_size(output)-std::filesystem::file_size(init_output);
+  return Measurement{
+    init_time,
+    num_events/event_time,
+    accepted/event_time,
+    std::max(init_result.max_rss, run_result.max_rss)/1024.,
+    accepted > 0 ? event_bytes/accepted : 0.
+  };
+}
+
+/**
+ * write the measurements as JSON
+ *
+ * Each configuration is on its own line so that the results can be
+ * compared with line-based tools as well as JSON parsers.
+ */
+static void write_json(std::ostream& o, int num_events,
+    const std::vector<std::pair<std::string, Measurement>>& results) {
+  o << "{\n"
+    << "  \"version\": \"" << version::STRING << "\",\n"
+    << "  \"events\": " << num_events << ",\n"
+    << "  \"configurations\": {\n";
+  for (std::size_t i{0}; i < results.size(); ++i) {
+    const auto& [name, m] = results[i];
+    o << "    \"" << name << "\": {"
+      << "\"init_s\": " << m.init_time << ", "
+      << "\"events_per_s\": " << m.events_per_second << ", "
+      << "\"accepted_per_s\": " << m.accepted_per_second << ", "
+      << "\"peak_rss_mb\": " << m.peak_rss << ", "
+      << "\"bytes_per_event\": " << m.bytes_per_event << "}"
+      << (i+1 < results.size() ? ",\n" : "\n");
+  }
+  o << "  }\n"
+    << "}\n";
+}
+
+/**
+ * read the events per second and peak RSS of each configuration from a baseline
+ *
+ * We only need to read the files that we write, so we rely on each configuration
+ * being on its own line rather than parsing general JSON.
+ */
+static std::map<std::string, std::pair<double, double>> read_baseline(const std::string& filepath) {
+  std::ifstream f{filepath};
+  if (not f.is_open()) {
+    throw std::runtime_error("Unable to open baseline '"+filepath+"'.");
+  }
+  static const std::regex line_pattern{
+    "\"([^\"]+)\": \\{.*\"events_per_s\": ([^,]+),.*\"peak_rss_mb\": ([^,]+),.*"
+  };
+  std::map<std::string, std::pair<double, double>> baseline;
+  std::string line;
+  std::smatch match;
+  while (std::getline(f, line)) {
+    if (std::regex_search(line, match, line_pattern)) {
+      baseline[match[1]] = {std::stod(match[2]), std::stod(match[3])};
+    }
+  }
+  return baseline;
+}
+
+/**
+ * definition of dimuon-bench
+ */
+int main(int argc, char* argv[]) try {
+  int num_events{1000};
+  std::string output, baseline_file, only, keep;
+  std::string simulate{subprocess::sibling("dimuon-simulate")};
+  for (int i_arg{1}; i_arg < argc; ++i_arg) {
+    std::string arg{argv[i_arg]};
+    if (arg == "-h" or arg == "--help") {
+      usage();
+      return 0;
+    } else if (arg == "-n" or arg == "--events") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      num_events = std::stoi(argv[++i_arg]);
+    } else if (arg == "-o" or arg == "--output") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      output = argv[++i_arg];
+    } else if (arg == "--baseline") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      baseline_file = argv[++i_arg];
+    } else if (arg == "--only") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      only = argv[++i_arg];
+    } else if (arg == "--simulate") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      simulate = argv[++i_arg];
+    } else if (arg == "--keep") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      keep = argv[++i_arg];
+    } else {
+      std::cerr << arg << " is not a recognized option" << std::endl;
+      return 1;
+    }
+  }
+
+  if (num_events <= 0) {
+    std::cerr << "The number of events must be positive." << std::endl;
+    return 1;
+  }
+
+  std::map<std::string, std::pair<double, double>> baseline;
+  if (not baseline_file.empty()) baseline = read_baseline(baseline_file);
+
+  std::filesystem::path dir;
+  if (keep.empty()) {
+    std::string tmpl{(std::filesystem::temp_directory_path() / "dimuon-bench-XXXXXX").string()};
+    if (mkdtemp(tmpl.data()) == nullptr) {
+      throw std::runtime_error("Unable to create a temporary directory for the benchmark.");
+    }
+    dir = tmpl;
+  } else {
+    dir = keep;
+    std::filesystem::create_directories(dir);
+  }
+
+  std::vector<std::pair<std::string, Measurement>> results;
+  for (const Configuration& config : matrix()) {
+    if (not only.empty() and config.name.find(only) == std::string::npos) continue;
+    std::cerr << config.name << "..." << std::flush;
+    Measurement m{measure(simulate, config, num_events, dir)};
+    std::cerr << " " << m.events_per_second << " events/s";
+    if (auto it{baseline.find(config.name)}; it != baseline.end()) {
+      std::cerr << " (" << std::setprecision(3) << m.events_per_second/it->second.first
+        << "x baseline, peak RSS " << m.peak_rss/it->second.second << "x baseline)"
+        << std::setprecision(6);
+    }
+    std::cerr << std::endl;
+    results.emplace_back(config.name, m);
+  }
+
+  if (keep.empty()) std::filesystem::remove_all(dir);
+
+  if (output.empty()) {
+    write_json(std::cout, num_events, results);
+  } else {
+    std::ofstream f{output};
+    if (not f.is_open()) {
+      std::cerr << "File '" << output << "' was not able to be opened." << std::endl;
+      return 2;
+    }
+    write_json(f, num_events, results);
+  }
+
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "ERROR: " << e.what() << std::endl;
+  return 127;
+}
@@ -0,0 +1,392 @@
+/**
+ * @file campaign.cxx
+ * definition of dimuon-campaign executable
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <thread>
+
+#include "G4Material.hh"
+#include "G4NistManager.hh"
+#include "G4SystemOfUnits.hh"
+
+#include "Subprocess.h"
+
+/**
+ * print out how to use dimuon-campaign
+ */
+void usage() {
+  std::cout <<
+    "USAGE:\n"
+    "  dimuon-campaign [options] OUTDIR\n"
+    "\n"
+    "Run dimuon-simulate over a matrix of samples using all of the local cores.\n"
+    "Each sample (depth, material, mode, bias, and filter) is split into shards with\n"
+    "different seeds and the shards are run as a work queue, longest first, so that\n"
+    "no core sits idle while there is still work to do. The expected length of each\n"
+    "shard comes from the CPU time per event of the shards finished in earlier runs\n"
+    "of the campaign. Finished shards are recorded in OUTDIR/campaign.state so that\n"
+    "running the same command again resumes the campaign. Once all of the shards of\n"
+    "a sample are finished, they are merged with dimuon-merge into OUTDIR/SAMPLE.root.\n"
+    "\n"
+    "ARGUMENTS\n"
+    "  OUTDIR             : directory to write the samples, logs, and state into\n"
+    "\n"
+    "OPTIONS\n"
+    "  -h,--help          : produce this help and exit\n"
+    "  -j,--jobs          : number of shards to run at once, default is the number of cores\n"
+    "  --depths           : comma-separated target depths in radiation lengths of the material (required)\n"
+    "  --materials        : comma-separated target materials as named in G4NistManager, default G4_W\n"
+    "  --modes            : comma-separated modes to run, default inclusive,dimuon\n"
+    "                       inclusive : no biasing or filtering\n"
+    "                       dimuon    : biased and filtered for muon-conversions\n"
+    "  --bias             : comma-separated bias factors for the dimuon mode, default 1e4\n"
+    "  --filter           : comma-separated filter thresholds in MeV for the dimuon mode, default 1000\n"
+    "  --shards           : number of shards (seeds 1 to N) in each sample, default 1\n"
+    "  --inclusive-events : number of events in each inclusive shard, default 10000\n"
+    "  --dimuon-events    : number of events in each dimuon shard, default 1000000\n"
+    "  --beam             : beam energy in GeV, default 8\n"
+    "  --simulate         : path to dimuon-simulate, default is the one next to dimuon-campaign\n"
+    "  --merge            : path to dimuon-merge, default is the one next to dimuon-campaign\n"
+    "  --dry-run          : print the shards that would be run in order and exit\n"
+    << std::flush;
+}
+
+/// a single run of dimuon-simulate
+struct Shard {
+  /// name of the sample this shard is a part of
+  std::string sample;
+  /// name of this shard, used for its output and log files
+  std::string name;
+  /// mode of the shard, inclusive or dimuon
+  std::string mode;
+  /// depth of target in radiation lengths
+  double depth_x0;
+  /// number of events requested
+  long events;
+  /// arguments to dimuon-simulate besides the number of events and output
+  std::vector<std::string> args;
+};
+
+/// a finished shard as recorded in the state file
+struct Record {
+  /// mode of the shard
+  std::string mode;
+  /// depth of target in radiation lengths
+  double depth_x0;
+  /// number of events requested
+  long events;
+  /// CPU time it took [s]
+  double cpu_time;
+};
+
+/// split a comma-separated list
+static std::vector<std::string> split(const std::string& list) {
+  std::vector<std::string> items;
+  std::stringstream ss{list};
+  std::string item;
+  while (std::getline(ss, item, ',')) {
+    if (not item.empty()) items.push_back(item);
+  }
+  return items;
+}
+
+/// format a number without trailing zeros for use in names
+static std::string format(double value) {
+  std::stringstream ss;
+  ss << value;
+  return ss.str();
+}
+
+/**
+ * the matrix of shards to run
+ *
+ * The depths are converted from radiation lengths to mm using the
+ * radiation length of each material from G4NistManager.
+ */
+static std::vector<Shard> matrix(const std::vector<std::string>& depths, const std::vector<std::string>& materials,
+    const std::vector<std::string>& modes, const std::vector<std::string>& biases,
+    const std::vector<std::string>& filters, int shards, long inclusive_events, long dimuon_events, double beam) {
+  std::vector<Shard> jobs;
+  for (const std::string& material : materials) {
+    G4Material* mat{G4NistManager::Instance()->FindOrBuildMaterial(material)};
+    if (mat == nullptr) {
+      throw std::runtime_error("Material '"+material+"' unknown to G4NistManager.");
+    }
+    for (const std::string& depth : depths) {
+      double depth_x0{std::stod(depth)};
+      std::vector<std::string> common{
+        "--target", material,
+        "--depth", std::to_string(depth_x0*mat->GetRadlen()/CLHEP::mm),
+        "--beam", format(beam)
+      };
+      std::string prefix{material+"_"+format(depth_x0)+"X0"};
+      for (const std::string& mode : modes) {
+        std::vector<std::pair<std::string, std::vector<std::string>>> samples;
+        if (mode == "inclusive") {
+          samples.push_back({"inclusive_"+prefix, common});
+        } else if (mode == "dimuon") {
+          for (const std::string& bias : biases) {
+            for (const std::string& filter : filters) {
+              std::vector<std::string> args{common};
+              args.insert(args.end(), {"--bias", bias, "--filter", filter});
+              samples.push_back({"dimuon_"+prefix+"_bias"+format(std::stod(bias))
+                  +"_filter"+format(std::stod(filter)), args});
+            }
+          }
+        } else {
+          throw std::runtime_error("Unknown mode '"+mode+"', it should be inclusive or dimuon.");
+        }
+        for (const auto& [sample, args] : samples) {
+          for (int seed{1}; seed <= shards; ++seed) {
+            Shard shard{sample, sample+"_s"+std::to_string(seed), mode, depth_x0,
+              mode == "inclusive" ? inclusive_events : dimuon_events, args};
+            shard.args.insert(shard.args.end(), {"--seed", std::to_string(seed)});
+            jobs.push_back(shard);
+          }
+        }
+      }
+    }
+  }
+  return jobs;
+}
+
+/**
+ * the state of the campaign from earlier runs
+ *
+ * The state file has one line per finished shard
+ *   done NAME MODE DEPTH_X0 EVENTS CPU_TIME
+ * and one line per merged sample
+ *   merged SAMPLE
+ */
+struct State {
+  /// finished shards by name
+  std::map<std::string, Record> done;
+  /// merged samples
+  std::set<std::string> merged;
+};
+
+static State read_state(const std::filesystem::path& filepath) {
+  State state;
+  std::ifstream f{filepath};
+  std::string line;
+  while (std::getline(f, line)) {
+    std::stringstream ss{line};
+    std::string kind, name;
+    ss >> kind >> name;
+    if (kind == "done") {
+      Record r;
+      if (ss >> r.mode >> r.depth_x0 >> r.events >> r.cpu_time) state.done[name] = r;
+    } else if (kind == "merged") {
+      state.merged.insert(name);
+    }
+  }
+  return state;
+}
+
+/**
+ * CPU time per event per radiation length of each mode from the finished shards
+ *
+ * The shower (and so the time to simulate it) grows with the depth of the
+ * target, so this is a rough but serviceable model for ordering the shards.
+ * Modes without any finished shards use the average of the others or one.
+ */
+static std::map<std::string, double> rates(const State& state) {
+  std::map<std::string, std::pair<double, double>> sums;
+  for (const auto& [name, r] : state.done) {
+    sums[r.mode].first += r.cpu_time;
+    sums[r.mode].second += r.events*std::max(r.depth_x0, 0.1);
+  }
+  std::map<std::string, double> rate;
+  double total{0.};
+  for (const auto& [mode, sum] : sums) {
+    if (sum.second > 0.) rate[mode] = sum.first/sum.second;
+    total += rate[mode];
+  }
+  rate[""] = rate.empty() ? 1. : total/rate.size();
+  return rate;
+}
+
+/// expected CPU time of a shard
+static double estimate(const Shard& shard, const std::map<std::string, double>& rate) {
+  auto it{rate.find(shard.mode)};
+  double r{it != rate.end() ? it->second : rate.at("")};
+  return r*shard.events*std::max(shard.depth_x0, 0.1);
+}
+
+/**
+ * definition of dimuon-campaign
+ */
+int main(int argc, char* argv[]) try {
+  unsigned int n_jobs{std::max(1u, std::thread::hardware_concurrency())};
+  std::string depths, materials{"G4_W"}, modes{"inclusive,dimuon"}, biases{"1e4"}, filters{"1000"};
+  int n_shards{1};
+  long inclusive_events{10000}, dimuon_events{1000000};
+  double beam{8.};
+  bool dry_run{false};
+  std::string simulate{subprocess::sibling("dimuon-simulate")};
+  std::string merge{subprocess::sibling("dimuon-merge")};
+  std::vector<std::string> positional;
+  for (int i_arg{1}; i_arg < argc; ++i_arg) {
+    std::string arg{argv[i_arg]};
+    if (arg == "-h" or arg == "--help") {
+      usage();
+      return 0;
+    } else if (arg == "--dry-run") {
+      dry_run = true;
+    } else if (arg == "-j" or arg == "--jobs" or arg == "--depths" or arg == "--materials"
+        or arg == "--modes" or arg == "--bias" or arg == "--filter" or arg == "--shards"
+        or arg == "--inclusive-events" or arg == "--dimuon-events" or arg == "--beam"
+        or arg == "--simulate" or arg == "--merge") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      std::string value{argv[++i_arg]};
+      if (arg == "-j" or arg == "--jobs") n_jobs = std::stoul(value);
+      else if (arg == "--depths") depths = value;
+      else if (arg == "--materials") materials = value;
+      else if (arg == "--modes") modes = value;
+      else if (arg == "--bias") biases = value;
+      else if (arg == "--filter") filters = value;
+      else if (arg == "--shards") n_shards = std::stoi(value);
+      else if (arg == "--inclusive-events") inclusive_events = std::stol(value);
+      else if (arg == "--dimuon-events") dimuon_events = std::stol(value);
+      else if (arg == "--beam") beam = std::stod(value);
+      else if (arg == "--simulate") simulate = value;
+      else merge = value;
+    } else if (arg[0] == '-') {
+      std::cerr << arg << " is not a recognized option" << std::endl;
+      return 1;
+    } else {
+      positional.push_back(arg);
+    }
+  }
+
+  if (positional.size() != 1) {
+    usage();
+    std::cerr << "\nExactly one OUTDIR is required!\n" << std::flush;
+    return 1;
+  }
+
+  if (depths.empty()) {
+    std::cerr << "At least one depth is required." << std::endl;
+    return 1;
+  }
+
+  if (n_jobs == 0 or n_shards <= 0) {
+    std::cerr << "The number of jobs and shards must be positive." << std::endl;
+    return 1;
+  }
+
+  std::filesystem::path outdir{positional[0]};
+  std::filesystem::create_directories(outdir / "shards");
+  std::filesystem::path state_file{outdir / "campaign.state"};
+
+  std::vector<Shard> shards{matrix(split(depths), split(materials), split(modes),
+      split(biases), split(filters), n_shards, inclusive_events, dimuon_events, beam)};
+  State state{read_state(state_file)};
+  auto rate{rates(state)};
+
+  auto shard_output = [&](const std::string& name) {
+    return outdir / "shards" / (name+".root");
+  };
+  std::vector<Shard> pending;
+  for (const Shard& shard : shards) {
+    if (state.done.count(shard.name) and std::filesystem::exists(shard_output(shard.name))) continue;
+    pending.push_back(shard);
+  }
+  std::stable_sort(pending.begin(), pending.end(), [&](const Shard& a, const Shard& b) {
+    return estimate(a, rate) > estimate(b, rate);
+  });
+
+  std::cout << "[ dimuon-campaign ]: " << pending.size() << " of " << shards.size()
+    << " shards to run on " << n_jobs << " cores." << std::endl;
+  if (dry_run) {
+    for (const Shard& shard : pending) {
+      std::cout << shard.name << " (estimated " << estimate(shard, rate) << ")" << std::endl;
+    }
+    return 0;
+  }
+
+  std::ofstream state_out{state_file, std::ios::app};
+  if (not state_out.is_open()) {
+    throw std::runtime_error("Unable to open state file '"+state_file.string()+"'.");
+  }
+
+  /**
+   * the work queue
+   *
+   * We keep up to n_jobs shards running, starting the next longest
+   * shard as soon as any running shard finishes.
+   */
+  std::map<pid_t, std::pair<Shard, std::chrono::steady_clock::time_point>> running;
+  std::size_t next{0}, n_failed{0};
+  while (next < pending.size() or not running.empty()) {
+    while (next < pending.size() and running.size() < n_jobs) {
+      const Shard& shard{pending[next++]};
+      std::vector<std::string> args{simulate};
+      args.insert(args.end(), shard.args.begin(), shard.args.end());
+      args.push_back(std::to_string(shard.events));
+      args.push_back(shard_output(shard.name).string());
+      pid_t pid{subprocess::spawn(args, (outdir / "shards" / (shard.name+".log")).string())};
+      running.emplace(pid, std::make_pair(shard, std::chrono::steady_clock::now()));
+    }
+    subprocess::Result result{subprocess::wait()};
+    auto it{running.find(result.pid)};
+    if (it == running.end()) continue;
+    const auto& [shard, start] = it->second;
+    std::chrono::duration<double> wall{std::chrono::steady_clock::now()-start};
+    double cpu_time{result.user_time+result.system_time};
+    if (result.exit_code == 0) {
+      state_out << "done " << shard.name << " " << shard.mode << " " << shard.depth_x0
+        << " " << shard.events << " " << cpu_time << std::endl;
+      state.done[shard.name] = Record{shard.mode, shard.depth_x0, shard.events, cpu_time};
+      std::cout << "[ dimuon-campaign ]: " << shard.name << " finished in " << wall.count() << "s" << std::endl;
+    } else {
+      ++n_failed;
+      std::cerr << "[ dimuon-campaign ]: " << shard.name << " exited with " << result.exit_code
+        << ", see its log in " << (outdir / "shards").string() << std::endl;
+    }
+    running.erase(it);
+  }
+
+  // merge the samples whose shards are all finished
+  std::map<std::string, std::vector<std::string>> samples;
+  for (const Shard& shard : shards) samples[shard.sample].push_back(shard.name);
+  for (const auto& [sample, names] : samples) {
+    if (state.merged.count(sample)) continue;
+    bool finished{std::all_of(names.begin(), names.end(), [&](const std::string& name) {
+          return state.done.count(name) > 0;
+        })};
+    if (not finished) continue;
+    std::vector<std::string> args{merge, (outdir / (sample+".root")).string()};
+    for (const std::string& name : names) args.push_back(shard_output(name).string());
+    subprocess::Result result{subprocess::run(args, (outdir / (sample+"_merge.log")).string())};
+    if (result.exit_code == 0) {
+      state_out << "merged " << sample << std::endl;
+      std::cout << "[ dimuon-campaign ]: merged " << sample << std::endl;
+    } else {
+      ++n_failed;
+      std::cerr << "[ dimuon-campaign ]: merging " << sample << " exited with " << result.exit_code << std::endl;
+    }
+  }
+
+  if (n_failed > 0) {
+    std::cerr << "[ dimuon-campaign ]: " << n_failed << " jobs failed, run the same command again to retry them."
+      << std::endl;
+    return 3;
+  }
+
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "ERROR: " << e.what() << std::endl;
+  return 127;
+}
@@ -0,0 +1,252 @@
+/**
+ * @file ecal_coverage.cxx
+ * definition of dimuon-ecal-coverage executable
+ */
+
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+
+#include "ROOT/RDataFrame.hxx"
+#include "TFile.h"
+#include "TH2D.h"
+#include "TParameter.h"
+#include "TTree.h"
+
+/**
+ * print out how to use dimuon-ecal-coverage
+ */
+void usage() {
+  std::cout <<
+    "USAGE:\n"
+    "  dimuon-ecal-coverage [options] OUTPUT INPUT [INPUT ...]\n"
+    "\n"
+    "Count the ECal simulated hits in each cell by the particle causing them and the\n"
+    "number of muon hits in each layer of each event from ldmx-sw event files.\n"
+    "This is the same as position.py but streams the events in parallel so only the\n"
+    "counts are held in memory.\n"
+    "\n"
+    "A hit is caused by a muon (electron) if any of its contributions are from a\n"
+    "mu+ or mu- (e-) and by something else otherwise. Only hits with more than\n"
+    "a tenth of a MIP (0.13 MeV) of energy deposited are counted.\n"
+    "\n"
+    "ARGUMENTS\n"
+    "  OUTPUT       : output ROOT file to write the counts and EoT to\n"
+    "  INPUT        : one or more ldmx-sw event files\n"
+    "\n"
+    "OPTIONS\n"
+    "  -h,--help    : produce this help and exit\n"
+    "  -j,--threads : number of threads to use, default is 0 which means all available cores\n"
+    "  --hits       : name of the ECal sim hits collection, default EcalSimHits_dimuon\n"
+    "  --weight     : name of the event weight branch, default weight_\n"
+    "  --tries      : number of simulated events to use instead of the sum of numTries_\n"
+    "                 from the run trees (e.g. for samples without run trees)\n"
+    "\n"
+    "OUTPUT\n"
+    "  cells        : tree with one entry per cell with its ID, center, and counts of\n"
+    "                 hits caused by muons, electrons, and other particles\n"
+    "  layer_nhits  : number of muon hits in each layer for each event\n"
+    "  eot, tries   : equivalent and simulated number of electrons on target\n"
+    << std::flush;
+}
+
+/// energy deposited by a MIP in an ECal silicon sensor [MeV]
+static const double MIP_ENERGY = 0.13;
+/// fraction of a MIP a hit must have to be read out
+static const double READOUT_THRESHOLD = 0.1;
+/// number of layers in the ECal
+static const int NUM_LAYERS = 34;
+
+/// the counts in a single cell
+struct CellCounts {
+  /// number of hits caused by muons, electrons, and other particles
+  double muon{0.}, electron{0.}, other{0.};
+  /// center of the cell [mm], taken from the first hit in it
+  double x{0.}, y{0.};
+};
+
+/// get the layer of an ECal cell from its ID
+static int layer(int cellid) {
+  return (cellid >> 17) & 0x3f;
+}
+
+/**
+ * definition of dimuon-ecal-coverage
+ *
+ * Each processing slot has its own map of cell counts which are
+ * combined after the single (parallel) pass over the events.
+ */
+int main(int argc, char* argv[]) try {
+  unsigned int n_threads{0};
+  std::string hits_name{"EcalSimHits_dimuon"}, weight_name{"weight_"};
+  std::optional<double> tries{};
+  std::vector<std::string> positional;
+  for (int i_arg{1}; i_arg < argc; ++i_arg) {
+    std::string arg{argv[i_arg]};
+    if (arg == "-h" or arg == "--help") {
+      usage();
+      return 0;
+    } else if (arg == "-j" or arg == "--threads") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      n_threads = std::stoi(argv[++i_arg]);
+    } else if (arg == "--hits") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      hits_name = argv[++i_arg];
+    } else if (arg == "--weight") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      weight_name = argv[++i_arg];
+    } else if (arg == "--tries") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      tries = std::stod(argv[++i_arg]);
+    } else if (arg[0] == '-') {
+      std::cerr << arg << " is not a recognized option" << std::endl;
+      return 1;
+    } else {
+      positional.push_back(arg);
+    }
+  }
+
+  if (positional.size() < 2) {
+    usage();
+    std::cerr << "\nOUTPUT and at least one INPUT are required!\n" << std::flush;
+    return 1;
+  }
+
+  std::string output_filename{positional[0]};
+  std::vector<std::string> inputs{positional.begin()+1, positional.end()};
+
+  if (not tries) {
+    // numTries_ is an int per run, but the sum over a campaign can overflow one
+    tries = ROOT::RDataFrame("LDMX_Run", inputs).Sum<int, Long64_t>("numTries_").GetValue();
+  }
+
+  ROOT::EnableImplicitMT(n_threads);
+  ROOT::RDataFrame df("LDMX_Events", inputs);
+
+  std::vector<std::unordered_map<int, CellCounts>> slot_cells(df.GetNSlots());
+  auto n_events = df.Count();
+  auto weight_sum = df.Sum<double>(weight_name);
+
+  auto events = df
+    .Define("cause", [](const ROOT::RVecF& edep, const ROOT::RVec<std::vector<int>>& pdg) {
+        // 0 is not read out, 1 muon, 2 electron, 3 muon and electron, 4 other
+        ROOT::RVecI cause(edep.size(), 0);
+        for (std::size_t i{0}; i < edep.size(); ++i) {
+          if (edep[i] <= READOUT_THRESHOLD*MIP_ENERGY) continue;
+          for (int code : pdg[i]) {
+            if (code == 13 or code == -13) cause[i] |= 1;
+            else if (code == 11) cause[i] |= 2;
+          }
+          if (cause[i] == 0) cause[i] = 4;
+        }
+        return cause;
+      }, {hits_name+".edep_", hits_name+".pdgCodeContribs_"});
+
+  /**
+   * every event fills every layer, even if it has no muon hits in it
+   */
+  auto layer_nhits = events
+    .Define("layer", []() {
+        ROOT::RVecD layers(NUM_LAYERS);
+        for (int i{0}; i < NUM_LAYERS; ++i) layers[i] = i;
+        return layers;
+      }, {})
+    .Define("nhits", [](const ROOT::RVecI& ids, const ROOT::RVecI& cause) {
+        ROOT::RVecD nhits(NUM_LAYERS, 0.);
+        for (std::size_t i{0}; i < ids.size(); ++i) {
+          int l{layer(ids[i])};
+          if ((cause[i] & 1) and l < NUM_LAYERS) nhits[l] += 1;
+        }
+        return nhits;
+      }, {hits_name+".id_", "cause"})
+    .Histo2D<ROOT::RVecD, ROOT::RVecD>(
+        {"layer_nhits", ";Layer;Muon Hits in Layer per Event",
+         NUM_LAYERS, 0., static_cast<double>(NUM_LAYERS), 501, -0.5, 500.5},
+        "layer", "nhits");
+
+  /**
+   * the event loop is run here, filling the histogram booked above as well
+   */
+  events.ForeachSlot([&slot_cells](unsigned int slot, const ROOT::RVecI& ids, const ROOT::RVecI& cause,
+        const ROOT::RVecF& x, const ROOT::RVecF& y) {
+      auto& cells{slot_cells[slot]};
+      for (std::size_t i{0}; i < ids.size(); ++i) {
+        auto [it, inserted] = cells.try_emplace(ids[i]);
+        CellCounts& cell{it->second};
+        if (inserted) {
+          cell.x = x[i];
+          cell.y = y[i];
+        }
+        if (cause[i] & 1) cell.muon += 1;
+        if (cause[i] & 2) cell.electron += 1;
+        if (cause[i] & 4) cell.other += 1;
+      }
+    }, {hits_name+".id_", "cause", hits_name+".x_", hits_name+".y_"});
+  layer_nhits->SetDirectory(nullptr);
+
+  std::map<int, CellCounts> cells;
+  for (const auto& slot : slot_cells) {
+    for (const auto& [id, counts] : slot) {
+      auto [it, inserted] = cells.try_emplace(id, counts);
+      if (inserted) continue;
+      it->second.muon += counts.muon;
+      it->second.electron += counts.electron;
+      it->second.other += counts.other;
+    }
+  }
+
+  double eot{*weight_sum > 0. ? *n_events / *weight_sum * tries.value() : 0.};
+  std::cout
+    << "Parameter         : Value\n"
+    << "Num Inputs        : " << inputs.size() << "\n"
+    << "Sim EoT           : " << tries.value() << "\n"
+    << "Num Events        : " << *n_events << "\n"
+    << "EoT               : " << eot << "\n"
+    << "Num Cells         : " << cells.size() << "\n"
+    << "Destination       : " << output_filename << "\n"
+    << std::flush;
+
+  TFile out{output_filename.c_str(), "RECREATE"};
+  if (not out.IsOpen()) {
+    std::cerr << "File '" << output_filename << "' was not able to be opened." << std::endl;
+    return 2;
+  }
+  int cellid;
+  CellCounts counts;
+  TTree cell_tree("cells", "ECal hit counts by cell and cause");
+  cell_tree.Branch("cellid", &cellid, "cellid/I");
+  cell_tree.Branch("muon", &counts.muon, "muon/D");
+  cell_tree.Branch("electron", &counts.electron, "electron/D");
+  cell_tree.Branch("other", &counts.other, "other/D");
+  cell_tree.Branch("x", &counts.x, "x/D");
+  cell_tree.Branch("y", &counts.y, "y/D");
+  for (const auto& [id, c] : cells) {
+    cellid = id;
+    counts = c;
+    cell_tree.Fill();
+  }
+  cell_tree.Write();
+  layer_nhits->Write();
+  TParameter<double>("eot", eot).Write();
+  TParameter<double>("tries", tries.value()).Write();
+  out.Close();
+
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "ERROR: " << e.what() << std::endl;
+  return 127;
+}
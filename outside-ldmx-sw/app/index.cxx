@@ -0,0 +1,81 @@
+/**
+ * @file index.cxx
+ * definition of dimuon-index executable
+ */
+
+#include <iostream>
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include "EventIndex.h"
+
+/**
+ * print out how to use dimuon-index
+ */
+void usage() {
+  std::cout <<
+    "USAGE:\n"
+    "  dimuon-index [options] FILE [FILE ...]\n"
+    "\n"
+    "Build sorted indices of the muon kinematics in dimuon-simulate output files.\n"
+    "The indices are written into the same file next to the events so selections\n"
+    "on these keys only need to read the matching entries.\n"
+    "Indices are not carried over by dimuon-merge, re-index the merged file instead.\n"
+    "\n"
+    "ARGUMENTS\n"
+    "  FILE      : one or more output files of dimuon-simulate to index in place\n"
+    "\n"
+    "OPTIONS\n"
+    "  -h,--help : produce this help and exit\n"
+    "\n"
+    "KEYS\n";
+  for (const std::string& key : event_index::KEYS) {
+    std::cout << "  " << key << "\n";
+  }
+  std::cout << std::flush;
+}
+
+/**
+ * definition of dimuon-index
+ */
+int main(int argc, char* argv[]) try {
+  std::vector<std::string> files;
+  for (int i_arg{1}; i_arg < argc; ++i_arg) {
+    std::string arg{argv[i_arg]};
+    if (arg == "-h" or arg == "--help") {
+      usage();
+      return 0;
+    } else if (arg[0] == '-') {
+      std::cerr << arg << " is not a recognized option" << std::endl;
+      return 1;
+    } else {
+      files.push_back(arg);
+    }
+  }
+
+  if (files.empty()) {
+    usage();
+    std::cerr << "\nAt least one FILE is required!\n" << std::flush;
+    return 1;
+  }
+
+  for (const std::string& file : files) {
+    TFile f{file.c_str(), "UPDATE"};
+    if (not f.IsOpen()) {
+      throw std::runtime_error("Unable to open '"+file+"' for updating.");
+    }
+    auto events{f.Get<TTree>("events")};
+    if (not events) {
+      throw std::runtime_error("'"+file+"' does not have an events tree.");
+    }
+    event_index::build(events, &f);
+    std::cout << "Indexed " << events->GetEntries() << " events in " << file << std::endl;
+    f.Close();
+  }
+
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "ERROR: " << e.what() << std::endl;
+  return 127;
+}
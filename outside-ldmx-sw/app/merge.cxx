@@ -0,0 +1,156 @@
+/**
+ * @file merge.cxx
+ * definition of dimuon-merge executable
+ */
+
+#include <iostream>
+#include <map>
+#include <memory>
+
+#include "TChain.h"
+#include "TClass.h"
+#include "TFile.h"
+#include "TH1.h"
+#include "TKey.h"
+#include "TTree.h"
+
+#include "RunHeader.h"
+
+/**
+ * print out how to use dimuon-merge
+ */
+void usage() {
+  std::cout <<
+    "USAGE:\n"
+    "  dimuon-merge [options] OUTPUT INPUT [INPUT ...]\n"
+    "\n"
+    "Merge the output files of dimuon-simulate into a single file.\n"
+    "The run headers are checked to have been configured the same and then their\n"
+    "counters are summed into a single run header. Any histograms written alongside\n"
+    "the events (e.g. the photon fluence) are summed as well. The events are copied\n"
+    "without decompressing them unless re-clustering is requested.\n"
+    "\n"
+    "ARGUMENTS\n"
+    "  OUTPUT        : output ROOT file to write merged events and run header to\n"
+    "  INPUT         : one or more output files of dimuon-simulate\n"
+    "\n"
+    "OPTIONS\n"
+    "  -h,--help     : produce this help and exit\n"
+    "  --recluster N : re-write the events into clusters of N entries\n"
+    "                  this requires decompressing and recompressing all of the events\n"
+    "                  but can help the read performance of many small input files\n"
+    << std::flush;
+}
+
+/**
+ * definition of dimuon-merge
+ */
+int main(int argc, char* argv[]) try {
+  Long64_t cluster_size{0};
+  std::vector<std::string> positional;
+  for (int i_arg{1}; i_arg < argc; ++i_arg) {
+    std::string arg{argv[i_arg]};
+    if (arg == "-h" or arg == "--help") {
+      usage();
+      return 0;
+    } else if (arg == "--recluster") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      cluster_size = std::stoll(argv[++i_arg]);
+    } else if (arg[0] == '-') {
+      std::cerr << arg << " is not a recognized option" << std::endl;
+      return 1;
+    } else {
+      positional.push_back(arg);
+    }
+  }
+
+  if (positional.size() < 2) {
+    usage();
+    std::cerr << "\nOUTPUT and at least one INPUT are required!\n" << std::flush;
+    return 1;
+  }
+
+  std::string output_filename{positional[0]};
+  std::vector<std::string> inputs{positional.begin()+1, positional.end()};
+
+  /**
+   * merge the run headers and any histograms first so we
+   * can bail out before copying any events if the runs are not compatible
+   */
+  std::unique_ptr<RunHeader> run_header;
+  std::map<std::string, std::unique_ptr<TH1>> histograms;
+  TChain events("events");
+  for (const std::string& input : inputs) {
+    TFile f{input.c_str()};
+    if (not f.IsOpen()) {
+      throw std::runtime_error("Unable to open '"+input+"'.");
+    }
+    std::unique_ptr<RunHeader> rh{f.Get<RunHeader>("run")};
+    if (not rh) {
+      throw std::runtime_error("'"+input+"' does not have a run header.");
+    }
+    try {
+      if (run_header) run_header->merge(*rh);
+      else run_header = std::move(rh);
+    } catch (const std::runtime_error& e) {
+      throw std::runtime_error("'"+input+"' is incompatible with previous inputs. "+e.what());
+    }
+    for (TObject* obj : *f.GetListOfKeys()) {
+      auto key{static_cast<TKey*>(obj)};
+      TClass* cls{TClass::GetClass(key->GetClassName())};
+      if (cls == nullptr or not cls->InheritsFrom(TH1::Class())) continue;
+      std::unique_ptr<TH1> h{static_cast<TH1*>(key->ReadObj())};
+      h->SetDirectory(nullptr);
+      auto it{histograms.find(key->GetName())};
+      if (it == histograms.end()) {
+        histograms.emplace(key->GetName(), std::move(h));
+      } else {
+        it->second->Add(h.get());
+      }
+    }
+    events.Add(input.c_str());
+  }
+
+  TFile out{output_filename.c_str(), "RECREATE"};
+  if (not out.IsOpen()) {
+    std::cerr << "File '" << output_filename << "' was not able to be opened." << std::endl;
+    return 2;
+  }
+
+  TTree* merged{nullptr};
+  events.LoadTree(0);
+  if (cluster_size > 0) {
+    merged = events.CloneTree(0);
+    merged->SetAutoFlush(cluster_size);
+    merged->CopyEntries(&events);
+  } else {
+    // 'fast' copies the compressed baskets without decompressing them
+    merged = events.CloneTree(-1, "fast");
+  }
+  if (not merged) {
+    throw std::runtime_error("Unable to copy the events into the output file.");
+  }
+
+  out.WriteObject(run_header.get(), "run");
+  for (const auto& [name, h] : histograms) out.WriteTObject(h.get(), name.c_str());
+  merged->Write();
+
+  std::cout
+    << "Parameter         : Value\n"
+    << "Num Inputs        : " << inputs.size() << "\n"
+    << "Sim EoT           : " << run_header->tries() << "\n"
+    << "Num Events        : " << merged->GetEntries() << "\n"
+    << "EoT               : " << run_header->eot() << " +- " << run_header->eot_uncertainty() << "\n"
+    << "Destination       : " << output_filename << "\n"
+    << std::flush;
+
+  out.Close();
+
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "ERROR: " << e.what() << std::endl;
+  return 127;
+}
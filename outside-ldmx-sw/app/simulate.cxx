@@ -6,6 +6,7 @@
 #include <fstream>
 #include <iostream>
 #include <memory>
+#include <sstream>
 
 #include "QBBC.hh"
 #include "G4PhysListFactory.hh"
@@ -18,11 +19,30 @@
 #include "G4UIsession.hh"
 #include "G4UImanager.hh"
 #include "G4GenericBiasingPhysics.hh"
+#include "G4Electron.hh"
+#include "G4Gamma.hh"
+#include "G4MuonPlus.hh"
 
 #include "Beam.h"
+#include "BiasTable.h"
+#include "EventMonitor.h"
+#include "FastSimulationPhysics.h"
+#include "BremBiasing.h"
+#include "CombinedBiasing.h"
+#include "MuonConversionBiasing.h"
+#include "PhaseSpaceRecorder.h"
+#include "PhaseSpaceSource.h"
 #include "GammaPhysics.h"
 #include "Hunk.h"
+#include "LeakageModel.h"
+#include "LeakageTrainer.h"
 #include "PersistParticles.h"
+#include "PhotonFluence.h"
+#include "Selection.h"
+#include "StepProfiler.h"
+#include "Telemetry.h"
+#include "TrackCulling.h"
+#include "WeightWindow.h"
 #include "Version.h"
 
 class SilenceGeant : public G4UIsession {
@@ -33,21 +53,38 @@ class SilenceGeant : public G4UIsession {
 
 class SteppingAction : public G4UserSteppingAction {
   PersistParticles& persister_;
+  PhotonFluence* fluence_;
+  TrackCulling* culling_;
+  LeakageTrainer* trainer_;
+  StepProfiler* profiler_;
  public:
-  SteppingAction(PersistParticles& persister)
-    : G4UserSteppingAction(), persister_{persister} {}
+  SteppingAction(PersistParticles& persister, PhotonFluence* fluence, TrackCulling* culling, LeakageTrainer* trainer,
+      StepProfiler* profiler)
+    : G4UserSteppingAction(), persister_{persister}, fluence_{fluence}, culling_{culling}, trainer_{trainer},
+      profiler_{profiler} {}
   void UserSteppingAction(const G4Step* step) final {
     persister_.UserSteppingAction(step);
+    if (fluence_) fluence_->UserSteppingAction(step);
+    if (trainer_) trainer_->UserSteppingAction(step);
+    // last so the others see the step before the track is killed
+    if (culling_) culling_->UserSteppingAction(step);
+    // after all of the others so their time is included in the step
+    if (profiler_) profiler_->UserSteppingAction(step);
   }
 };
 
 class TrackingAction : public G4UserTrackingAction {
   PersistParticles& persister_;
+  ScoringPlaneSD& ecal_;
+  StepProfiler* profiler_;
  public:
-  TrackingAction(PersistParticles& persister)
-    : G4UserTrackingAction(), persister_{persister} {}
+  TrackingAction(PersistParticles& persister, ScoringPlaneSD& ecal, StepProfiler* profiler)
+    : G4UserTrackingAction(), persister_{persister}, ecal_{ecal}, profiler_{profiler} {}
   void PreUserTrackingAction(const G4Track* track) final {
     persister_.PreUserTrackingAction(track);
+    ecal_.PreUserTrackingAction(track);
+    // last so the first step is timed from when the track starts moving
+    if (profiler_) profiler_->PreUserTrackingAction(track);
   }
   void PostUserTrackingAction(const G4Track* track) final {
     persister_.PostUserTrackingAction(track);
@@ -56,27 +93,63 @@ class TrackingAction : public G4UserTrackingAction {
 
 class EventAction : public G4UserEventAction {
   PersistParticles& persister_;
+  PhaseSpaceRecorder* recorder_;
+  EventMonitor* monitor_;
+  Telemetry* telemetry_;
+  LeakageTrainer* trainer_;
+  PhotonFluence* fluence_;
  public:
-  EventAction(PersistParticles& persister)
-    : G4UserEventAction(), persister_{persister} {}
+  EventAction(PersistParticles& persister, PhaseSpaceRecorder* recorder, EventMonitor* monitor, Telemetry* telemetry,
+      LeakageTrainer* trainer, PhotonFluence* fluence)
+    : G4UserEventAction(), persister_{persister}, recorder_{recorder}, monitor_{monitor}, telemetry_{telemetry},
+      trainer_{trainer}, fluence_{fluence} {}
   void BeginOfEventAction(const G4Event* event) final {
     persister_.BeginOfEventAction(event);
+    if (recorder_) recorder_->BeginOfEventAction(event);
+    if (monitor_) monitor_->BeginOfEventAction(event);
+    if (trainer_) trainer_->BeginOfEventAction(event);
   }
   void EndOfEventAction(const G4Event* event) final {
+    if (monitor_) monitor_->EndOfEventAction(persister_.num_extra(), persister_.num_ecal());
+    bool truncated{monitor_ and monitor_->aborted_event()};
+    if (truncated) persister_.TruncateEvent();
+    if (fluence_) fluence_->EndOfEventAction(not truncated);
     persister_.EndOfEventAction(event);
+    if (telemetry_) {
+      telemetry_->update(persister_.events_started(), persister_.events_completed(), persister_.weight_sum());
+    }
   }
 };
 
 class StackingAction : public G4UserStackingAction {
   PersistParticles& persister_;
+  PhaseSpaceRecorder* recorder_;
+  WeightWindow* window_;
+  EventMonitor* monitor_;
+  LeakageTrainer* trainer_;
+  /// true while the waiting tracks are being sorted into the next stage
+  bool reclassifying_{false};
  public:
-  StackingAction(PersistParticles& persister)
-    : G4UserStackingAction(), persister_{persister} {}
+  StackingAction(PersistParticles& persister, PhaseSpaceRecorder* recorder, WeightWindow* window, EventMonitor* monitor,
+      LeakageTrainer* trainer)
+    : G4UserStackingAction(), persister_{persister}, recorder_{recorder}, window_{window}, monitor_{monitor},
+      trainer_{trainer} {}
   G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track) final {
+    /**
+     * tracks being re-classified at a new stage were already seen by the others,
+     * so only the stage is decided again (e.g. no second roulette or split)
+     */
+    if (reclassifying_) return persister_.ClassifyNewTrack(track);
+    if (monitor_ and monitor_->ClassifyNewTrack(track)) return fKill;
+    if (trainer_) trainer_->ClassifyNewTrack(track);
+    if (recorder_ and recorder_->ClassifyNewTrack(track)) return fKill;
+    if (window_ and window_->ClassifyNewTrack(track)) return fKill;
     return persister_.ClassifyNewTrack(track);
   }
   void NewStage() final {
+    reclassifying_ = true;
     persister_.NewStage();
+    reclassifying_ = false;
   }
 };
 
@@ -109,9 +182,68 @@ void usage() {
     "                  default is no filtering (i.e. there can be no muons or muons with any energy)\n"
     "  -b, --bias    : biasing factor to use to encourage muon-conv\n"
     "                  default if this flag is not provided is no biasing\n"
+    "  --bias-function : make the muon-conv biasing factor depend on the photon energy (requires --bias)\n"
+    "                    flat : scale by E/sigma(E) so the conversion energies are roughly flat,\n"
+    "                           with the --bias factor at the filter threshold (requires --filter)\n"
+    "                    FILE : CSV of energies in MeV and relative factors, multiplied by the --bias factor\n"
+    "  --stack-tiers : comma-separated list of kinetic energies in MeV above the filter threshold\n"
+    "                  to process the shower in stages of, checking after each stage if a muon\n"
+    "                  passing the filter is still possible so hopeless events are aborted sooner\n"
+    "  --brem-bias   : biasing factor to use to encourage brem of electrons above the filter threshold\n"
+    "                  default if this flag is not provided is no brem biasing\n"
     "  -e, --beam    : Beam energy in GeV (defaults to 8)\n"
     "  -s, --seed    : set seed for Geant4's random number generator\n"
     "                  default is 0 so consecutive runs without changing anything will produce identical results\n"
+    "  --fluence     : score the photon track length within the target binned in energy and depth\n"
+    "                  and write it to the output file as 'photon_fluence' for use with dimuon-yield\n"
+    "                  requires an unfiltered run since aborted events would not score their full shower\n"
+    "  --phase-space-out : write photons produced within the target to the input phase space file\n"
+    "                      instead of simulating them (electron beams without biasing or roulette only)\n"
+    "  --phase-space-min : minimum energy in MeV of photons to write to the phase space file\n"
+    "                      defaults to the filter threshold or 1000 MeV if not filtering\n"
+    "  --phase-space-in  : generate events from the photons in the input phase space file\n"
+    "                      instead of from the beam, NUM-EVENTS is limited to the number of\n"
+    "                      events in the phase space file\n"
+    "  --roulette    : apply a weight window to electrons, positrons, and photons produced within\n"
+    "                  the target below the input kinetic energy in MeV, tracks lighter than the window\n"
+    "                  are rouletted and tracks heavier than it are split, so the particles leaving\n"
+    "                  the target must be counted with their weights\n"
+    "                  meant for inclusive runs and cannot be used with --bias\n"
+    "  --roulette-survival : probability that an unweighted track heading upstream survives, default 0.1\n"
+    "  --split       : number of copies to split an unweighted track heading downstream into\n"
+    "  --cull        : kill tracks in the air that can no longer reach the target or the ECal scoring plane\n"
+    "                  comma-separated list of categories (past-ecal, backsplash, no-path) or 'all'\n"
+    "                  the number of tracks killed in each category is written as 'culled_tracks'\n"
+    "  --target-precision : stop the run once the relative uncertainty on the muon-conversion yield\n"
+    "                      is below the input value, NUM-EVENTS becomes the maximum number of events\n"
+    "  --precision-bins   : comma-separated edges of bins in the leading muon energy in MeV which must\n"
+    "                      each reach the target precision as well\n"
+    "  --cpu-budget  : stop the run after the input number of seconds of CPU time\n"
+    "  --monitor     : fill histograms of the peak number of stacked tracks, the number of tracks created,\n"
+    "                  the number of particles recorded, and the resident memory of each event\n"
+    "  --max-stack   : abort events with more than the input number of tracks on the stacks (implies --monitor)\n"
+    "  --max-rss     : end the run early (closing the output properly) if the resident memory\n"
+    "                  grows above the input number of MB (implies --monitor)\n"
+    "  --telemetry   : periodically rewrite the input file with the progress of the run\n"
+    "                  written in the Prometheus text format if the file ends in '.prom' and JSON otherwise\n"
+    "  --telemetry-period : minimum number of seconds between rewrites of the telemetry file, default 10\n"
+    "  --train-leakage : tabulate the particles leaving the target from the shower of each electron, positron,\n"
+    "                    and photon below the input kinetic energy in MeV and write the tables to the output file\n"
+    "                    requires an unbiased, unfiltered run without roulette\n"
+    "  --fast-leakage  : replace electrons, positrons, and photons in the target below the maximum energy of\n"
+    "                    the tables in the input file written by --train-leakage with the particles leaving\n"
+    "                    the target sampled from the tables instead of simulating their shower\n"
+    "  --select      : only write events passing the input predicates, e.g. 'mu_min_energy > 2000 and mu_ecal_hits == 2'\n"
+    "                  can be given more than once, see the README for the available variables\n"
+    "                  the EoT is still calculated from all events passing the filter\n"
+    "  --select-file : add the predicates in the input file (one or more per line) to the selection\n"
+    "  --ecal-direction : which particles crossing the ECal scoring plane to record, each is recorded\n"
+    "                     at most once per event when it enters the plane\n"
+    "                     downstream (default, heading away from the target), upstream, or both\n"
+    "  --profile-steps : count the steps and their wall time by particle, starting volume, and limiting process,\n"
+    "                    print the most expensive and write the full table as the 'step_profile' tree\n"
+    "  --derived     : write the pair mass, opening angle, muon polar and azimuthal angles, and muon\n"
+    "                  radii at the ECal scoring plane as additional flat branches of the events\n"
     "  --mat-list    : print the full list from G4NistManager and exit\n"
     "\n"
     "EXAMPLES\n"
@@ -128,6 +260,26 @@ void usage() {
     "\n"
     "    g4db-simulate --mat-list | less\n"
     "\n"
+    "  Score the photon fluence with a short unbiased run to predict the muon-conversion yield.\n"
+    "\n"
+    "    g4db-simulate --depth 10*3.50259 --fluence 1000 fluence_10X0.root\n"
+    "\n"
+    "  Estimate the leakage with a fraction of the transported tracks by rouletting\n"
+    "  the low-energy shower and splitting the particles heading towards the ECal.\n"
+    "\n"
+    "    g4db-simulate --depth 10*3.50259 --roulette 50 --split 4 10000 inclusive_10X0.root\n"
+    "\n"
+    "  Bias the brem of the beam electron as well so more events have a hard photon to convert.\n"
+    "\n"
+    "    g4db-simulate --depth 10*3.50259 --bias 1e4 --brem-bias 10 --filter 1000 10000 dimuon_10X0.root\n"
+    "\n"
+    "  Simulate the electron showers once, recording the photons above 1GeV, and then\n"
+    "  simulate the muon-conversions of those photons with different bias factors.\n"
+    "\n"
+    "    g4db-simulate --depth 10*3.50259 --filter 1000 --phase-space-out photons_10X0.ps 1000000 stage1_10X0.root\n"
+    "    g4db-simulate --depth 10*3.50259 --filter 1000 --bias 1e4 --phase-space-in photons_10X0.ps 1000000 dimuon_10X0_1e4.root\n"
+    "    g4db-simulate --depth 10*3.50259 --filter 1000 --bias 1e3 --phase-space-in photons_10X0.ps 1000000 dimuon_10X0_1e3.root\n"
+    "\n"
     << std::flush;
 }
 
@@ -142,10 +294,33 @@ int main(int argc, char* argv[]) try {
   double depth{0.350259};
   std::string target{"G4_W"};
   std::optional<double> bias{};
+  std::optional<double> brem_bias{};
+  std::string bias_function;
   std::optional<double> filter_threshold{};
   double beam{8.};
   std::vector<std::string> positional;
   long seed{0};
+  bool fluence_scoring{false};
+  std::string phase_space_out, phase_space_in;
+  std::optional<double> phase_space_min{};
+  std::optional<double> roulette_energy{};
+  double roulette_survival{0.1};
+  unsigned int split{1};
+  std::string cull;
+  std::vector<double> stack_tiers;
+  bool monitor_events{false};
+  bool derived{false};
+  bool profile_steps{false};
+  ScoringPlaneSD::Direction ecal_direction{ScoringPlaneSD::Downstream};
+  Selection selection;
+  std::optional<double> train_leakage{};
+  std::string fast_leakage;
+  std::optional<double> target_precision{}, cpu_budget{};
+  std::vector<double> precision_bins;
+  std::string telemetry_file;
+  double telemetry_period{10.};
+  std::optional<long unsigned int> max_stack{};
+  std::optional<double> max_rss{};
   for (int i_arg{1}; i_arg < argc; ++i_arg) {
     std::string arg{argv[i_arg]};
     if (arg == "-h" or arg == "--help") {
@@ -162,6 +337,140 @@ int main(int argc, char* argv[]) try {
       return 0;
     } else if (arg == "--photons") {
       photons = true;
+    } else if (arg == "--fluence") {
+      fluence_scoring = true;
+    } else if (arg == "--phase-space-out") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      phase_space_out = argv[++i_arg];
+    } else if (arg == "--phase-space-min") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      phase_space_min = std::stod(argv[++i_arg]);
+    } else if (arg == "--phase-space-in") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      phase_space_in = argv[++i_arg];
+    } else if (arg == "--roulette") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      roulette_energy = std::stod(argv[++i_arg]);
+    } else if (arg == "--roulette-survival") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      roulette_survival = std::stod(argv[++i_arg]);
+    } else if (arg == "--split") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      split = std::stoul(argv[++i_arg]);
+    } else if (arg == "--stack-tiers") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      std::stringstream tiers{argv[++i_arg]};
+      std::string tier;
+      while (std::getline(tiers, tier, ',')) stack_tiers.push_back(std::stod(tier));
+    } else if (arg == "--target-precision") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      target_precision = std::stod(argv[++i_arg]);
+    } else if (arg == "--precision-bins") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      std::stringstream edges{argv[++i_arg]};
+      std::string edge;
+      while (std::getline(edges, edge, ',')) precision_bins.push_back(std::stod(edge));
+    } else if (arg == "--cpu-budget") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      cpu_budget = std::stod(argv[++i_arg]);
+    } else if (arg == "--telemetry") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      telemetry_file = argv[++i_arg];
+    } else if (arg == "--telemetry-period") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      telemetry_period = std::stod(argv[++i_arg]);
+    } else if (arg == "--monitor") {
+      monitor_events = true;
+    } else if (arg == "--derived") {
+      derived = true;
+    } else if (arg == "--profile-steps") {
+      profile_steps = true;
+    } else if (arg == "--ecal-direction") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      ecal_direction = ScoringPlaneSD::direction(argv[++i_arg]);
+    } else if (arg == "--select") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      selection.add(argv[++i_arg]);
+    } else if (arg == "--select-file") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      selection.add_file(argv[++i_arg]);
+    } else if (arg == "--train-leakage") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      train_leakage = std::stod(argv[++i_arg]);
+    } else if (arg == "--fast-leakage") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      fast_leakage = argv[++i_arg];
+    } else if (arg == "--max-stack") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      max_stack = std::stoul(argv[++i_arg]);
+      monitor_events = true;
+    } else if (arg == "--max-rss") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      max_rss = std::stod(argv[++i_arg]);
+      monitor_events = true;
+    } else if (arg == "--cull") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      cull = argv[++i_arg];
     } else if (arg == "-t" or arg == "--target") {
       if (i_arg+1 >= argc) {
         std::cerr << arg << " requires an argument after it" << std::endl;
@@ -180,6 +489,18 @@ int main(int argc, char* argv[]) try {
         return 1;
       }
       bias = std::stod(argv[++i_arg]);
+    } else if (arg == "--bias-function") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      bias_function = argv[++i_arg];
+    } else if (arg == "--brem-bias") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      brem_bias = std::stod(argv[++i_arg]);
     } else if (arg == "-f" or arg == "--filter") {
       if (i_arg+1 >= argc) {
         std::cerr << arg << " requires an argument after it" << std::endl;
@@ -212,6 +533,59 @@ int main(int argc, char* argv[]) try {
     return 1;
   }
 
+  if (fluence_scoring and filter_threshold) {
+    std::cerr << "--fluence cannot be used with --filter since aborted events do not score their full shower" << std::endl;
+    return 1;
+  }
+
+  if (not phase_space_out.empty() and photons) {
+    std::cerr << "--phase-space-out cannot be used with --photons since the primary photon"
+      " and its muon-conversions would be missing from the replayed sample" << std::endl;
+    return 1;
+  }
+
+  if (not phase_space_out.empty() and (bias or brem_bias or roulette_energy)) {
+    std::cerr << "--phase-space-out cannot be used with --bias, --brem-bias, or --roulette since"
+      " the weight of the stage 1 event would be lost when the photons are replayed" << std::endl;
+    return 1;
+  }
+
+  if (not phase_space_out.empty() and not phase_space_in.empty()) {
+    std::cerr << "Only one of --phase-space-out and --phase-space-in can be used at a time" << std::endl;
+    return 1;
+  }
+
+  if (roulette_energy and (bias or brem_bias)) {
+    std::cerr << "--roulette cannot be used with --bias or --brem-bias since the track weights would mix both" << std::endl;
+    return 1;
+  }
+
+  if (not bias_function.empty() and not bias) {
+    std::cerr << "--bias-function requires --bias to set the scale of the factor" << std::endl;
+    return 1;
+  }
+
+  if (bias_function == "flat" and not filter_threshold) {
+    std::cerr << "--bias-function flat requires --filter to set the energy the --bias factor is at" << std::endl;
+    return 1;
+  }
+
+  if (split > 1 and not roulette_energy) {
+    std::cerr << "--split requires --roulette to define the energy below which tracks are split" << std::endl;
+    return 1;
+  }
+
+  if (train_leakage and (bias or brem_bias or filter_threshold or roulette_energy or not fast_leakage.empty())) {
+    std::cerr << "--train-leakage requires an unbiased, unfiltered run without --roulette or --fast-leakage"
+      " so the tables count the full shower" << std::endl;
+    return 1;
+  }
+
+  if (not fast_leakage.empty() and roulette_energy) {
+    std::cerr << "--fast-leakage cannot be used with --roulette since both replace the low-energy shower" << std::endl;
+    return 1;
+  }
+
   int num_events = std::stoi(positional[0]);
   std::string output = positional[1];
 
@@ -237,36 +611,169 @@ int main(int argc, char* argv[]) try {
 
   auto run = std::unique_ptr<G4RunManager>(new G4RunManager);
 
-  PersistParticles persister(output, filter_threshold, bias, target, depth, beam, photons, seed);
+  PersistParticles persister(output, filter_threshold, bias, brem_bias, target, depth, beam, photons, seed);
+  if (not stack_tiers.empty()) persister.SetStageTiers(stack_tiers);
+  if (derived) persister.AddDerivedBranches();
+  if (not selection.empty()) persister.SetSelection(selection);
+  std::optional<BiasTable> bias_table;
+  if (bias_function == "flat") {
+    G4Material* material{G4NistManager::Instance()->FindOrBuildMaterial(target)};
+    if (material == nullptr) {
+      throw std::runtime_error("Material '"+target+"' unknown to G4NistManager.");
+    }
+    bias_table = BiasTable::flat(bias.value(), filter_threshold.value(), beam*CLHEP::GeV, *material);
+  } else if (not bias_function.empty()) {
+    bias_table = BiasTable::from_csv(bias_function, bias.value());
+  }
+  if (bias_table) persister.SetBiasFunction(bias_table->description());
+  if (not precision_bins.empty() and not target_precision) {
+    std::cerr << "--precision-bins requires --target-precision" << std::endl;
+    return 1;
+  }
+  persister.SetStoppingCriteria(target_precision, precision_bins, cpu_budget);
+  /**
+   * 10 MeV wide energy bins at the default 8 GeV beam and
+   * 100 depth bins regardless of the depth of the target
+   */
+  std::optional<PhotonFluence> fluence;
+  if (fluence_scoring) fluence.emplace(depth, target, beam*CLHEP::GeV, 800, 100);
+  std::optional<PhaseSpaceRecorder> recorder;
+  if (not phase_space_out.empty()) {
+    recorder.emplace(phase_space_out, phase_space_min.value_or(filter_threshold.value_or(1000.)), depth);
+  }
+  std::optional<EventMonitor> monitor;
+  if (monitor_events) monitor.emplace(max_stack, max_rss);
+  std::optional<TrackCulling> culling;
+  if (not cull.empty()) culling.emplace(depth, cull);
+  std::optional<LeakageTrainer> trainer;
+  if (train_leakage) trainer.emplace(train_leakage.value(), depth);
+  std::optional<StepProfiler> profiler;
+  if (profile_steps) profiler.emplace();
+  std::optional<LeakageModel> leakage;
+  if (not fast_leakage.empty()) {
+    leakage.emplace(fast_leakage, target, depth);
+    // the muon-conversions passing the filter must not be replaced
+    if (filter_threshold and leakage->max_energy() > filter_threshold.value()) {
+      std::cerr << "The leakage model in '" << fast_leakage << "' replaces tracks up to "
+        << leakage->max_energy() << " MeV which is above the filter threshold" << std::endl;
+      return 1;
+    }
+    // without a filter, photons that could still convert to a muon pair must not be replaced either
+    double pair_threshold{2*G4MuonPlus::MuonPlus()->GetPDGMass()};
+    if (not filter_threshold and leakage->max_energy() > pair_threshold) {
+      std::cerr << "The leakage model in '" << fast_leakage << "' replaces tracks up to "
+        << leakage->max_energy() << " MeV which is above the muon-pair threshold of "
+        << pair_threshold << " MeV" << std::endl;
+      return 1;
+    }
+    persister.SetFastLeakage(leakage->description());
+  }
+  std::optional<WeightWindow> window;
+  if (roulette_energy) window.emplace(roulette_energy.value(), roulette_survival, split, depth);
+  PhaseSpaceSource* source{nullptr};
+  if (not phase_space_in.empty()) {
+    source = new PhaseSpaceSource(phase_space_in);
+    if (source->events() < static_cast<std::uint64_t>(num_events)) num_events = source->events();
+  }
+  std::optional<Telemetry> telemetry;
+  if (not telemetry_file.empty()) telemetry.emplace(telemetry_file, telemetry_period, num_events);
   ScoringPlaneSD ecal("ecal", persister);
 
+  /**
+   * only one biasing operator can be attached to the hunk,
+   * so we combine them if both muon-conversion and brem are biased
+   */
+  auto muon_conversion_biasing = [&]() {
+    if (bias_table) return new MuonConversionBiasing(bias_table.value(), filter_threshold.value_or(0.));
+    return new MuonConversionBiasing(bias.value(), filter_threshold.value_or(0.));
+  };
+  G4VBiasingOperator* biasing{nullptr};
+  if (bias and brem_bias) {
+    auto combined = new CombinedBiasing;
+    combined->add(G4Gamma::Gamma(), muon_conversion_biasing());
+    combined->add(G4Electron::Electron(), new BremBiasing(brem_bias.value(), filter_threshold.value_or(0.)));
+    biasing = combined;
+  } else if (bias) {
+    biasing = muon_conversion_biasing();
+  } else if (brem_bias) {
+    biasing = new BremBiasing(brem_bias.value(), filter_threshold.value_or(0.));
+  }
+
+  // the sensitive detector manager owns the plane
+  auto ecal_plane{new ScoringPlaneSD("ecal", persister, ecal_direction)};
   run->SetUserInitialization(
       new Hunk(
         depth,
         target,
-        new ScoringPlaneSD("ecal", persister),
-        bias ? new MuonConversionBiasing(bias.value(), filter_threshold.value_or(0.)) : nullptr
+        ecal_plane,
+        biasing,
+        leakage ? &leakage.value() : nullptr
       )
   );
 
   G4VModularPhysicsList* physics = new QBBC;
   physics->RegisterPhysics(new GammaPhysics);
-  if (bias) {
+  if (bias or brem_bias) {
     G4GenericBiasingPhysics* biased_physics = new G4GenericBiasingPhysics;
-    biased_physics->Bias("gamma", {"GammaToMuPair"});
+    if (bias) biased_physics->Bias("gamma", {"GammaToMuPair"});
+    if (brem_bias) biased_physics->Bias("e-", {"eBrem"});
     physics->RegisterPhysics(biased_physics);
   }
+  if (leakage) physics->RegisterPhysics(new FastSimulationPhysics);
   run->SetUserInitialization(physics);
 
   run->Initialize();
-  run->SetUserAction(new SteppingAction(persister));
-  run->SetUserAction(new TrackingAction(persister));
-  run->SetUserAction(new EventAction(persister));
-  run->SetUserAction(new Beam(beam, depth, photons));
-  run->SetUserAction(new StackingAction(persister));
+  run->SetUserAction(new SteppingAction(persister,
+        fluence ? &fluence.value() : nullptr,
+        culling ? &culling.value() : nullptr,
+        trainer ? &trainer.value() : nullptr,
+        profiler ? &profiler.value() : nullptr));
+  run->SetUserAction(new TrackingAction(persister, *ecal_plane, profiler ? &profiler.value() : nullptr));
+  run->SetUserAction(new EventAction(persister,
+        recorder ? &recorder.value() : nullptr,
+        monitor ? &monitor.value() : nullptr,
+        telemetry ? &telemetry.value() : nullptr,
+        trainer ? &trainer.value() : nullptr,
+        fluence ? &fluence.value() : nullptr));
+  if (source) run->SetUserAction(source);
+  else run->SetUserAction(new Beam(beam, depth, photons));
+  run->SetUserAction(new StackingAction(persister,
+        recorder ? &recorder.value() : nullptr,
+        window ? &window.value() : nullptr,
+        monitor ? &monitor.value() : nullptr,
+        trainer ? &trainer.value() : nullptr));
 
   run->BeamOn(num_events);
 
+  if (monitor and monitor->ended_run()) persister.SetStopReason("max-rss");
+
+  if (telemetry) {
+    telemetry->finish(persister.events_started(), persister.events_completed(), persister.weight_sum());
+  }
+
+  if (source) persister.SetEquivalentTries(source->tries());
+
+  if (fluence) {
+    persister.Write(fluence->spectrum(), "photon_fluence");
+    persister.Write(fluence->yield(), "photon_yield");
+    persister.Write(fluence->total(), "photon_yield_total");
+  }
+
+  if (culling) persister.Write(culling->killed(), "culled_tracks");
+
+  if (monitor) {
+    for (const TH1D* h : monitor->histograms()) persister.Write(*h, h->GetName());
+  }
+
+  if (trainer) {
+    for (const TH1* h : trainer->histograms()) persister.Write(*h, h->GetName());
+  }
+
+  if (profiler) {
+    profiler->print(std::cout);
+    persister.Write(*profiler->tree(), "step_profile");
+  }
+
   return 0;
 } catch (const std::exception& e) {
   std::cerr << "ERROR: " << e.what() << std::endl;
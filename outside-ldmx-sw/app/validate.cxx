@@ -0,0 +1,339 @@
+/**
+ * @file validate.cxx
+ * definition of dimuon-validate executable
+ */
+
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+
+#include "ROOT/RDataFrame.hxx"
+#include "TFile.h"
+#include "TMath.h"
+
+#include "Kinematics.h"
+#include "RunHeader.h"
+#include "Subprocess.h"
+
+/**
+ * print out how to use dimuon-validate
+ */
+void usage() {
+  std::cout <<
+    "USAGE:\n"
+    "  dimuon-validate [options] --fast ARGS NUM-EVENTS\n"
+    "\n"
+    "Check that a faster configuration of dimuon-simulate gives the same physics as a reference.\n"
+    "Both configurations are run with the input number of events and the weighted distributions\n"
+    "of the muon kinematics, the muon positions at the ECal scoring plane, and the energy leaving\n"
+    "the target are compared with chi2 and Kolmogorov-Smirnov tests using the weights of the\n"
+    "entries for the errors. The weighted muon-conversion yield per EoT is compared as well.\n"
+    "A comparison fails if its p-value is below the significance level.\n"
+    "The speedup of the fast configuration is reported as the ratio of the CPU time per EoT\n"
+    "and as the ratio of the figure of merit 1/(relative uncertainty on the yield^2 * CPU time).\n"
+    "\n"
+    "ARGUMENTS\n"
+    "  NUM-EVENTS      : number of events to simulate with each configuration\n"
+    "\n"
+    "OPTIONS\n"
+    "  -h,--help       : produce this help and exit\n"
+    "  --fast          : arguments to dimuon-simulate for the fast configuration (required)\n"
+    "                    given as a single string, e.g. \"--depth 35.0259 --bias 1e4 --filter 1000 --cull all\"\n"
+    "  --reference     : arguments to dimuon-simulate for the reference configuration\n"
+    "                    default \"--depth 35.0259 --bias 1e4 --filter 1000\"\n"
+    "  --fast-events   : number of events to simulate with the fast configuration, default NUM-EVENTS\n"
+    "  --alpha         : significance level of each comparison, default 0.01\n"
+    "  -o,--output     : ROOT file to write the compared histograms to\n"
+    "  -j,--threads    : number of threads to fill the histograms with, default is 0 which means all cores\n"
+    "  --simulate      : path to dimuon-simulate, default is the one next to dimuon-validate\n"
+    "  --keep          : directory to keep the output of each configuration in\n"
+    "                    default is to delete them after they are compared\n"
+    "\n"
+    "The exit code is 0 if all comparisons pass and 3 if any fail.\n"
+    << std::flush;
+}
+
+/// split the arguments given as a single string on whitespace
+static std::vector<std::string> split(const std::string& args) {
+  std::vector<std::string> split_args;
+  std::stringstream ss{args};
+  std::string arg;
+  while (ss >> arg) split_args.push_back(arg);
+  return split_args;
+}
+
+/// the output of a single configuration
+struct Sample {
+  /// histograms of the distributions we compare
+  std::vector<std::unique_ptr<TH1D>> histograms;
+  /// weighted muon-conversion yield per EoT
+  double yield;
+  /// uncertainty on the yield per EoT
+  double yield_uncertainty;
+  /// equivalent electrons on target
+  double eot;
+  /// CPU time of dimuon-simulate [s]
+  double cpu_time;
+};
+
+/**
+ * run dimuon-simulate and fill the histograms from its output
+ *
+ * The binning depends only on the beam energy so that the
+ * reference and fast histograms can be compared bin-by-bin.
+ */
+static Sample run(const std::string& simulate, const std::string& name, const std::vector<std::string>& config,
+    long num_events, const std::filesystem::path& dir) {
+  std::filesystem::path output{dir / (name+".root")};
+  std::string log{(dir / (name+".log")).string()};
+  std::vector<std::string> args{simulate};
+  args.insert(args.end(), config.begin(), config.end());
+  args.push_back(std::to_string(num_events));
+  args.push_back(output.string());
+  std::cerr << name << "..." << std::flush;
+  auto start{std::chrono::steady_clock::now()};
+  subprocess::Result result{subprocess::run(args, log)};
+  std::chrono::duration<double> wall{std::chrono::steady_clock::now()-start};
+  if (result.exit_code != 0) {
+    throw std::runtime_error("'"+simulate+"' exited with "+std::to_string(result.exit_code)
+        +", see '"+log+"' for its output.");
+  }
+  std::cerr << " " << wall.count() << "s" << std::endl;
+
+  std::unique_ptr<RunHeader> rh;
+  {
+    TFile f{output.c_str()};
+    rh.reset(f.Get<RunHeader>("run"));
+    if (not rh) {
+      throw std::runtime_error("'"+output.string()+"' does not have a run header.");
+    }
+  }
+  double max_energy{rh->beam()*1000.};
+
+  ROOT::RDataFrame df("events", output.string());
+  const bool use_track_weights{rh->bias() == 1. and rh->brem_bias() == 1.
+    and rh->bias_function().empty()};
+  auto leakage = df
+    .Define("leak_energy", [](const ROOT::RVec<Particle>& extra) {
+        ROOT::RVecD energies;
+        for (const Particle& p : extra) energies.push_back(p.total_energy());
+        return energies;
+      }, {"extra"})
+    .Define("leak_weight", [use_track_weights](const ROOT::RVec<Particle>& extra, double weight) {
+        ROOT::RVecD weights;
+        for (const Particle& p : extra) weights.push_back(use_track_weights ? p.track_weight() : weight);
+        return weights;
+      }, {"extra", "weight"});
+  std::vector<ROOT::RDF::RResultPtr<TH1D>> h;
+  h.push_back(leakage.Histo1D<ROOT::RVecD, ROOT::RVecD>(
+        {"leak_energy", ";Energy Leaving Target [MeV];Weighted Particles", 50, 0., max_energy},
+        "leak_energy", "leak_weight"));
+
+  auto plane_position = [](const Particle& mu, const ROOT::RVec<Particle>& ecal) {
+    const Particle* hit{kinematics::find_hit(ecal, mu.id())};
+    if (hit == nullptr) return ROOT::RVecD{};
+    auto position{hit->position()};
+    return ROOT::RVecD{position.X(), position.Y()};
+  };
+  auto muons = df
+    .Filter([](const Particle& mu_plus, const Particle& mu_minus) {
+        return mu_plus.is_valid() and mu_minus.is_valid();
+      }, {"mu_plus", "mu_minus"}, "muon-conversion")
+    .Define("weight_sq", [](double weight) { return weight*weight; }, {"weight"})
+    .Define("pair_mass", kinematics::pair_mass, {"mu_plus", "mu_minus"})
+    .Define("opening_angle", kinematics::opening_angle, {"mu_plus", "mu_minus"});
+  auto weight_sum = muons.Sum<double>("weight");
+  auto weight_sq_sum = muons.Sum<double>("weight_sq");
+  h.push_back(muons.Histo1D<double, double>(
+        {"pair_mass", ";Pair Invariant Mass [MeV];Weighted Events", 50, 0., max_energy/2},
+        "pair_mass", "weight"));
+  h.push_back(muons.Histo1D<double, double>(
+        {"opening_angle", ";Opening Angle [rad];Weighted Events", 50, 0., 1.},
+        "opening_angle", "weight"));
+  for (const std::string& mu : {"mu_plus", "mu_minus"}) {
+    auto muon = muons
+      .Define(mu+"_energy", [](const Particle& p) { return p.total_energy(); }, {mu})
+      .Define(mu+"_theta", [](const Particle& p) { return p.momentum().Theta(); }, {mu});
+    h.push_back(muon.Histo1D<double, double>(
+          {(mu+"_energy").c_str(), ";Energy [MeV];Weighted Events", 50, 0., max_energy},
+          mu+"_energy", "weight"));
+    h.push_back(muon.Histo1D<double, double>(
+          {(mu+"_theta").c_str(), ";Polar Angle [rad];Weighted Events", 50, 0., 1.},
+          mu+"_theta", "weight"));
+    auto at_ecal = muons
+      .Define(mu+"_ecal", plane_position, {mu, "ecal"})
+      .Filter([](const ROOT::RVecD& hit) { return not hit.empty(); }, {mu+"_ecal"}, mu+" at ECal")
+      .Define(mu+"_ecal_x", [](const ROOT::RVecD& hit) { return hit[0]; }, {mu+"_ecal"})
+      .Define(mu+"_ecal_y", [](const ROOT::RVecD& hit) { return hit[1]; }, {mu+"_ecal"});
+    for (const std::string& coord : {"x", "y"}) {
+      std::string column{mu+"_ecal_"+coord};
+      h.push_back(at_ecal.Histo1D<double, double>(
+            {column.c_str(), (";"+coord+" at ECal Scoring Plane [mm];Weighted Events").c_str(), 50, -500., 500.},
+            column, "weight"));
+    }
+  }
+
+  Sample sample;
+  // the event loop is run here when we first access a result
+  double tries = rh->tries();
+  sample.yield = tries > 0. ? *weight_sum/tries : 0.;
+  sample.yield_uncertainty = tries > 0. ? std::sqrt(*weight_sq_sum)/tries : 0.;
+  sample.eot = rh->eot();
+  sample.cpu_time = result.user_time+result.system_time;
+  for (auto& histogram : h) {
+    sample.histograms.emplace_back(static_cast<TH1D*>(histogram->Clone((name+"_"+histogram->GetName()).c_str())));
+    sample.histograms.back()->SetDirectory(nullptr);
+  }
+  return sample;
+}
+
+/**
+ * definition of dimuon-validate
+ */
+int main(int argc, char* argv[]) try {
+  std::string reference{"--depth 35.0259 --bias 1e4 --filter 1000"}, fast;
+  long fast_events{-1};
+  double alpha{0.01};
+  unsigned int n_threads{0};
+  std::string output, keep;
+  std::string simulate{subprocess::sibling("dimuon-simulate")};
+  std::vector<std::string> positional;
+  for (int i_arg{1}; i_arg < argc; ++i_arg) {
+    std::string arg{argv[i_arg]};
+    if (arg == "-h" or arg == "--help") {
+      usage();
+      return 0;
+    } else if (arg == "--fast" or arg == "--reference" or arg == "--fast-events" or arg == "--alpha"
+        or arg == "-o" or arg == "--output" or arg == "-j" or arg == "--threads"
+        or arg == "--simulate" or arg == "--keep") {
+      if (i_arg+1 >= argc) {
+        std::cerr << arg << " requires an argument after it" << std::endl;
+        return 1;
+      }
+      std::string value{argv[++i_arg]};
+      if (arg == "--fast") fast = value;
+      else if (arg == "--reference") reference = value;
+      else if (arg == "--fast-events") fast_events = std::stol(value);
+      else if (arg == "--alpha") alpha = std::stod(value);
+      else if (arg == "-o" or arg == "--output") output = value;
+      else if (arg == "-j" or arg == "--threads") n_threads = std::stoi(value);
+      else if (arg == "--simulate") simulate = value;
+      else keep = value;
+    } else if (arg[0] == '-') {
+      std::cerr << arg << " is not a recognized option" << std::endl;
+      return 1;
+    } else {
+      positional.push_back(arg);
+    }
+  }
+
+  if (positional.size() != 1 or fast.empty()) {
+    usage();
+    std::cerr << "\nNUM-EVENTS and --fast are required!\n" << std::flush;
+    return 1;
+  }
+
+  long num_events{std::stol(positional[0])};
+  if (fast_events < 0) fast_events = num_events;
+  if (num_events <= 0 or fast_events <= 0) {
+    std::cerr << "The number of events must be positive." << std::endl;
+    return 1;
+  }
+
+  std::filesystem::path dir;
+  if (keep.empty()) {
+    std::string tmpl{(std::filesystem::temp_directory_path() / "dimuon-validate-XXXXXX").string()};
+    if (mkdtemp(tmpl.data()) == nullptr) {
+      throw std::runtime_error("Unable to create a temporary directory for the validation.");
+    }
+    dir = tmpl;
+  } else {
+    dir = keep;
+    std::filesystem::create_directories(dir);
+  }
+
+  ROOT::EnableImplicitMT(n_threads);
+  Sample ref{run(simulate, "reference", split(reference), num_events, dir)};
+  Sample fst{run(simulate, "fast", split(fast), fast_events, dir)};
+
+  if (keep.empty()) std::filesystem::remove_all(dir);
+
+  bool passed{true};
+  std::cout
+    << std::setw(18) << std::left << "Distribution" << std::right
+    << std::setw(12) << "Ref Entries" << std::setw(12) << "Fast Entries"
+    << std::setw(12) << "chi2/ndf" << std::setw(12) << "chi2 p" << std::setw(12) << "KS p"
+    << "  Result\n";
+  for (std::size_t i{0}; i < ref.histograms.size(); ++i) {
+    TH1D& r{*ref.histograms[i]};
+    TH1D& f{*fst.histograms[i]};
+    std::string name{std::string(r.GetName()).substr(std::string("reference_").size())};
+    std::cout << std::setw(18) << std::left << name << std::right
+      << std::setw(12) << r.GetEntries() << std::setw(12) << f.GetEntries();
+    if (r.GetEntries() == 0 or f.GetEntries() == 0) {
+      passed = false;
+      std::cout << std::setw(36) << "" << "  FAIL (no entries)\n";
+      continue;
+    }
+    double chi2{0.};
+    int ndf{0}, igood{0};
+    double chi2_p{r.Chi2TestX(&f, chi2, ndf, igood, "WW")};
+    double ks_p{r.KolmogorovTest(&f)};
+    bool pass{chi2_p >= alpha and ks_p >= alpha};
+    passed = passed and pass;
+    std::cout << std::setw(12) << (ndf > 0 ? chi2/ndf : 0.) << std::setw(12) << chi2_p << std::setw(12) << ks_p
+      << "  " << (pass ? "PASS" : "FAIL") << "\n";
+  }
+
+  double yield_sigma{std::hypot(ref.yield_uncertainty, fst.yield_uncertainty)};
+  double yield_pull{yield_sigma > 0. ? (fst.yield-ref.yield)/yield_sigma : 0.};
+  double yield_p{TMath::Erfc(std::abs(yield_pull)/std::sqrt(2.))};
+  bool yield_pass{ref.yield > 0. and fst.yield > 0. and yield_p >= alpha};
+  passed = passed and yield_pass;
+  std::cout
+    << "\nYield per EoT\n"
+    << "  reference : " << ref.yield << " +- " << ref.yield_uncertainty << "\n"
+    << "  fast      : " << fst.yield << " +- " << fst.yield_uncertainty << "\n"
+    << "  pull      : " << yield_pull << " (p = " << yield_p << ")  " << (yield_pass ? "PASS" : "FAIL") << "\n";
+
+  /**
+   * the speedup
+   *
+   * The CPU time per EoT is the most direct comparison when both configurations
+   * have the same weights, but biasing changes the spread of the weights and so
+   * the precision reached per EoT. The figure of merit accounts for that by
+   * comparing the CPU time needed to reach the same precision on the yield.
+   */
+  auto figure_of_merit = [](const Sample& s) {
+    if (s.yield <= 0. or s.cpu_time <= 0.) return 0.;
+    double relative{s.yield_uncertainty/s.yield};
+    return 1./(relative*relative*s.cpu_time);
+  };
+  double ref_fom{figure_of_merit(ref)}, fast_fom{figure_of_merit(fst)};
+  std::cout
+    << "\nSpeedup\n"
+    << "  CPU time  : " << ref.cpu_time << "s reference, " << fst.cpu_time << "s fast\n"
+    << "  per EoT   : " << (fst.eot > 0. and ref.eot > 0. ? (ref.cpu_time/ref.eot)/(fst.cpu_time/fst.eot) : 0.) << "x\n"
+    << "  FOM       : " << (ref_fom > 0. ? fast_fom/ref_fom : 0.) << "x\n"
+    << "\n" << (passed ? "PASS" : "FAIL") << std::endl;
+
+  if (not output.empty()) {
+    TFile out{output.c_str(), "RECREATE"};
+    if (not out.IsOpen()) {
+      std::cerr << "File '" << output << "' was not able to be opened." << std::endl;
+      return 2;
+    }
+    for (auto& h : ref.histograms) h->Write();
+    for (auto& h : fst.histograms) h->Write();
+    out.Close();
+  }
+
+  return passed ? 0 : 3;
+} catch (const std::exception& e) {
+  std::cerr << "ERROR: " << e.what() << std::endl;
+  return 127;
+}
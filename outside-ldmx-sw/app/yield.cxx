@@ -0,0 +1,159 @@
+/**
+ * @file yield.cxx
+ * definition of dimuon-yield executable
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#include "TFile.h"
+#include "TH1D.h"
+
+#include "RunHeader.h"
+
+/**
+ * print out how to use dimuon-yield
+ */
+void usage() {
+  std::cout <<
+    "USAGE:\n"
+    "  dimuon-yield [options] OUTPUT INPUT [INPUT ...]\n"
+    "\n"
+    "Fold the photon track-length spectrum scored by 'dimuon-simulate --fluence'\n"
+    "with the muon-conversion cross section to predict the muon-conversion yield\n"
+    "per electron (or photon) on target. The yield in each depth bin of the target\n"
+    "is written out to a CSV table and the total is printed to the terminal.\n"
+    "\n"
+    "ARGUMENTS\n"
+    "  OUTPUT       : output file to write CSV table of yield per EoT to\n"
+    "  INPUT        : one or more output files of 'dimuon-simulate --fluence'\n"
+    "                 all inputs must use the same target material and binning\n"
+    "\n"
+    "OPTIONS\n"
+    "  -h,--help    : produce this help and exit\n"
+    << std::flush;
+}
+
+/**
+ * definition of dimuon-yield
+ *
+ * The expected number of muon-conversions is the integral of the photon
+ * fluence multiplied by the macroscopic cross section. The fluence within
+ * a bin is its track length divided by its volume while the macroscopic
+ * cross section is the inverse of the mean free path, so the volumes cancel
+ * and we just need to sum the track length divided by the mean free path.
+ * This folding is done event by event during the simulation (see PhotonFluence)
+ * so that we have the sum of the yields of the events and of their squares.
+ *
+ * The steps within a shower are correlated but the events are independent,
+ * so the uncertainty is the standard error of the mean yield per event where
+ * each of the EoT is an event (most of which may have not scored anything).
+ */
+int main(int argc, char* argv[]) try {
+  std::vector<std::string> positional;
+  for (int i_arg{1}; i_arg < argc; ++i_arg) {
+    std::string arg{argv[i_arg]};
+    if (arg == "-h" or arg == "--help") {
+      usage();
+      return 0;
+    } else if (arg[0] == '-') {
+      std::cerr << arg << " is not a recognized option" << std::endl;
+      return 1;
+    } else {
+      positional.push_back(arg);
+    }
+  }
+
+  if (positional.size() < 2) {
+    usage();
+    std::cerr << "\nOUTPUT and at least one INPUT are required!\n" << std::flush;
+    return 1;
+  }
+
+  std::string output_filename{positional[0]};
+  std::unique_ptr<TH1D> yield, total;
+  std::string target;
+  double tries{0.};
+  for (std::size_t i_input{1}; i_input < positional.size(); ++i_input) {
+    const std::string& input{positional[i_input]};
+    TFile f{input.c_str()};
+    if (not f.IsOpen()) {
+      throw std::runtime_error("Unable to open '"+input+"'.");
+    }
+    std::unique_ptr<RunHeader> rh{f.Get<RunHeader>("run")};
+    auto y{f.Get<TH1D>("photon_yield")};
+    auto t{f.Get<TH1D>("photon_yield_total")};
+    if (not rh or not y or not t) {
+      throw std::runtime_error("'"+input+"' is missing the run header or the photon yield"
+          " (files written before the yield was scored per event need to be re-simulated).");
+    }
+    if (target.empty()) {
+      target = rh->target();
+    } else if (target != rh->target()) {
+      throw std::runtime_error("'"+input+"' used target "+rh->target()+" but others used "+target+".");
+    }
+    tries += rh->tries();
+    if (yield) {
+      yield->Add(y);
+      total->Add(t);
+    } else {
+      yield.reset(static_cast<TH1D*>(y->Clone()));
+      yield->SetDirectory(nullptr);
+      total.reset(static_cast<TH1D*>(t->Clone()));
+      total->SetDirectory(nullptr);
+    }
+  }
+
+  std::ofstream table_file(output_filename);
+  if (!table_file.is_open()) {
+    std::cerr << "File '" << output_filename << "' was not able to be opened." << std::endl;
+    return 2;
+  }
+
+  /**
+   * standard error of the mean yield per EoT from the sum of the
+   * event yields and the sum of their squares
+   */
+  auto uncertainty = [&](double sum, double sum2) {
+    if (tries < 2) return 0.;
+    return std::sqrt(std::max(0., sum2 - sum*sum/tries)/(tries*(tries-1)));
+  };
+
+  std::cout
+    << "Parameter         : Value\n"
+    << "Target            : " << target << "\n"
+    << "Num Inputs        : " << positional.size()-1 << "\n"
+    << "Sim EoT           : " << tries << "\n"
+    << "Destination       : " << output_filename << "\n"
+    << std::flush;
+
+  table_file << "Depth Low [mm],Depth High [mm],Yield per EoT,Yield Uncertainty per EoT\n";
+
+  const TAxis* depth_axis{yield->GetXaxis()};
+  for (int i_depth{1}; i_depth <= depth_axis->GetNbins(); ++i_depth) {
+    double sum{yield->GetBinContent(i_depth)}, error{yield->GetBinError(i_depth)};
+    table_file
+      << depth_axis->GetBinLowEdge(i_depth) << ","
+      << depth_axis->GetBinUpEdge(i_depth) << ","
+      << sum/tries << ","
+      << uncertainty(sum, error*error) << "\n";
+  }
+
+  table_file.flush();
+  table_file.close();
+
+  double total_yield{total->GetBinContent(1)}, total_error{total->GetBinError(1)};
+  std::cout
+    << "Yield per EoT     : " << total_yield/tries
+    << " +- " << uncertainty(total_yield, total_error*total_error) << "\n"
+    << std::flush;
+
+  return 0;
+} catch (const std::exception& e) {
+  std::cerr << "ERROR: " << e.what() << std::endl;
+  return 127;
+}
@@ -0,0 +1,108 @@
+#include "BiasTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include "G4GammaConversionToMuons.hh"
+
+BiasTable::BiasTable(double min_energy, double max_energy, const std::function<double(double)>& function,
+    const std::string& description)
+  : log_min_{std::log(min_energy)},
+    inv_log_step_{(NUM_POINTS-1)/(std::log(max_energy)-std::log(min_energy))},
+    factors_(NUM_POINTS),
+    description_{description} {
+  for (std::size_t i{0}; i < NUM_POINTS; ++i) {
+    factors_[i] = function(std::exp(log_min_+i/inv_log_step_));
+  }
+}
+
+BiasTable BiasTable::from_csv(const std::string& filepath, double factor) {
+  std::ifstream f{filepath};
+  if (not f.is_open()) {
+    throw std::runtime_error("Unable to open bias table '"+filepath+"'.");
+  }
+  std::vector<double> log_energies, relative;
+  std::stringstream description;
+  description << "table " << factor << " x (";
+  std::string line;
+  while (std::getline(f, line)) {
+    line = line.substr(0, line.find('#'));
+    if (line.find_first_not_of(" \t\r,") == std::string::npos) continue;
+    std::size_t comma{line.find(',')};
+    double energy, rel;
+    try {
+      if (comma == std::string::npos) throw std::invalid_argument(line);
+      energy = std::stod(line.substr(0, comma));
+      rel = std::stod(line.substr(comma+1));
+    } catch (const std::invalid_argument&) {
+      // the header line, if there is one
+      if (log_energies.empty()) continue;
+      throw std::runtime_error("Unable to parse line '"+line+"' of bias table '"+filepath+"'.");
+    }
+    if (energy <= 0. or rel <= 0.) {
+      throw std::runtime_error("Energies and factors in bias table '"+filepath+"' must be positive.");
+    }
+    if (not log_energies.empty() and std::log(energy) <= log_energies.back()) {
+      throw std::runtime_error("Energies in bias table '"+filepath+"' must be increasing.");
+    }
+    if (not log_energies.empty()) description << ", ";
+    description << energy << " MeV: " << rel;
+    log_energies.push_back(std::log(energy));
+    relative.push_back(rel);
+  }
+  if (log_energies.size() < 2) {
+    throw std::runtime_error("Bias table '"+filepath+"' needs at least two energies.");
+  }
+  description << ")";
+  return BiasTable(std::exp(log_energies.front()), std::exp(log_energies.back()),
+      [&](double energy) {
+        double x{std::log(energy)};
+        std::size_t i{static_cast<std::size_t>(
+            std::upper_bound(log_energies.begin(), log_energies.end(), x)-log_energies.begin())};
+        i = std::clamp<std::size_t>(i, 1, log_energies.size()-1);
+        double t{(x-log_energies[i-1])/(log_energies[i]-log_energies[i-1])};
+        return factor*(relative[i-1]+t*(relative[i]-relative[i-1]));
+      }, description.str());
+}
+
+BiasTable BiasTable::flat(double factor, double reference_energy, double max_energy, const G4Material& material) {
+  /**
+   * the macroscopic cross section up to a constant,
+   * which is all that matters for the shape
+   */
+  G4GammaConversionToMuons process;
+  auto xsec = [&](double energy) {
+    double sum{0.};
+    const G4double* n_atoms{material.GetVecNbOfAtomsPerVolume()};
+    for (std::size_t i{0}; i < material.GetNumberOfElements(); ++i) {
+      const G4Element* element{material.GetElement(i)};
+      sum += n_atoms[i]*process.ComputeCrossSectionPerAtom(energy, element->GetZ(), element->GetN());
+    }
+    return sum;
+  };
+  double reference_xsec{xsec(reference_energy)};
+  if (reference_xsec <= 0.) {
+    throw std::runtime_error("There is no muon-conversion at "+std::to_string(reference_energy)
+        +" MeV to normalize the flat bias to.");
+  }
+  double upper{std::max(max_energy, 2*reference_energy)};
+  std::stringstream description;
+  description << "flat " << factor << " x (E/sigma(E)) / (E/sigma(E) at " << reference_energy
+    << " MeV) in " << material.GetName() << " up to " << upper << " MeV";
+  return BiasTable(reference_energy, upper,
+      [&](double energy) {
+        return factor*(energy/reference_energy)*(reference_xsec/xsec(energy));
+      }, description.str());
+}
+
+double BiasTable::operator()(double energy) const {
+  double x{(std::log(energy)-log_min_)*inv_log_step_};
+  if (x <= 0.) return factors_.front();
+  if (x >= NUM_POINTS-1) return factors_.back();
+  std::size_t i{static_cast<std::size_t>(x)};
+  double t{x-i};
+  return factors_[i]+t*(factors_[i+1]-factors_[i]);
+}
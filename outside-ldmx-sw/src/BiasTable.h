@@ -0,0 +1,86 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "G4Material.hh"
+
+/**
+ * an energy-dependent bias factor looked up from a precomputed table
+ *
+ * With a single bias factor, the accepted muon-conversions come mostly from
+ * photons just above the threshold since those are the most plentiful in the
+ * shower. An energy-dependent factor can move the conversions towards higher
+ * photon energies, evening out the statistical precision across the muon
+ * energy spectrum for the same CPU time.
+ *
+ * The factor is tabulated at log-spaced energies when the table is built,
+ * so looking it up is one logarithm and a linear interpolation.
+ * Energies outside of the table use the factor at the nearest end.
+ */
+class BiasTable {
+  /// log of the lowest energy in the table [log(MeV)]
+  double log_min_;
+  /// inverse of the spacing of the table in log energy
+  double inv_log_step_;
+  /// the factors at each energy in the table
+  std::vector<double> factors_;
+  /// description of the function the table was built from
+  std::string description_;
+  /**
+   * tabulate the input function between the input energies
+   *
+   * @param[in] min_energy lowest energy of the table [MeV]
+   * @param[in] max_energy highest energy of the table [MeV]
+   * @param[in] function bias factor as a function of energy [MeV]
+   * @param[in] description description of the function
+   */
+  BiasTable(double min_energy, double max_energy, const std::function<double(double)>& function,
+      const std::string& description);
+ public:
+  /// number of energies in the table
+  static const std::size_t NUM_POINTS = 256;
+
+  /**
+   * Tabulate relative factors from a CSV file
+   *
+   * Each line is an energy in MeV and a relative factor separated by a comma,
+   * in increasing energy. The relative factors are interpolated linearly in
+   * log energy and multiplied by the input factor. A header line and anything
+   * after a '#' are ignored.
+   *
+   * @throws std::runtime_error if the file cannot be opened or parsed
+   * @param[in] filepath path to the CSV file
+   * @param[in] factor factor to multiply the relative factors by
+   */
+  static BiasTable from_csv(const std::string& filepath, double factor);
+
+  /**
+   * Tabulate the factor giving a flat distribution of conversion energies
+   *
+   * The photons in a shower fall roughly as 1/E, so the rate of conversions
+   * at energy E is about sigma(E)/E. Biasing by E/sigma(E) makes this flat.
+   * The factor is normalized to the input factor at the reference energy.
+   *
+   * @throws std::runtime_error if there is no muon-conversion at the reference energy
+   * @param[in] factor bias factor at the reference energy
+   * @param[in] reference_energy lowest energy to bias [MeV]
+   * @param[in] max_energy highest energy of the table, usually the beam energy [MeV]
+   * @param[in] material material the photons are converting in
+   */
+  static BiasTable flat(double factor, double reference_energy, double max_energy, const G4Material& material);
+
+  /**
+   * Look up the factor at the input energy
+   *
+   * @param[in] energy kinetic energy of photon [MeV]
+   * @return bias factor at that energy
+   */
+  double operator()(double energy) const;
+
+  /// description of the function to record with the run
+  const std::string& description() const {
+    return description_;
+  }
+};
@@ -0,0 +1,38 @@
+#include "BremBiasing.h"
+
+#include "G4Electron.hh"
+#include "G4BiasingProcessInterface.hh"
+#include "G4Track.hh"
+
+G4VBiasingOperation* BremBiasing::ProposeOccurenceBiasingOperation(const G4Track* track, const G4BiasingProcessInterface* callingProcess) {
+  // only biasing electrons
+  if (track->GetDefinition() != G4Electron::Electron()) return 0;
+  // only biasing electrons above the configured threshold in energy
+  if (track->GetKineticEnergy() < threshold_) return 0;
+  // only biasing the brem process
+  std::string process_name = callingProcess->GetWrappedProcess()->GetProcessName();
+  if (process_name.compare("eBrem")!=0) return 0;
+  // got here with an electron and the brem process
+  double interaction_length = callingProcess->GetWrappedProcess()->GetCurrentInteractionLength();
+  double unbiased_xsec = 1./interaction_length;
+  double biased_xsec = unbiased_xsec * factor_;
+  operation_->SetBiasedCrossSection(biased_xsec);
+  operation_->Sample();
+  return operation_;
+}
+G4VBiasingOperation* BremBiasing::ProposeFinalStateBiasingOperation(const G4Track*, const G4BiasingProcessInterface*) {
+  return 0;
+}
+G4VBiasingOperation* BremBiasing::ProposeNonPhysicsBiasingOperation(const G4Track*, const G4BiasingProcessInterface*) {
+  return 0;
+}
+BremBiasing::BremBiasing(double factor, double threshold)
+  : G4VBiasingOperator("bias-brem"), factor_{factor}, threshold_{threshold}, operation_{nullptr} {}
+BremBiasing::~BremBiasing() {
+  if (operation_) delete operation_;
+}
+void BremBiasing::StartRun() {
+  // re-starting run somehow so we are already configured
+  if (operation_) return;
+  operation_ = new G4BOptnChangeCrossSection("xsec-bias-brem");
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include "G4VBiasingOperator.hh"
+#include "G4BOptnChangeCrossSection.hh"
+
+/**
+ * bias the bremsstrahlung of electrons within the hunk
+ *
+ * With an electron beam, a muon-conversion first requires a hard brem photon.
+ * Increasing the occurence of brem for electrons above the filtering threshold
+ * means more of the events reach the muon-conversion decision with a photon
+ * that could pass the filter. The change in occurence is tracked by Geant4 in
+ * the weights of the electrons, so the event weights stay correct.
+ */
+class BremBiasing : public G4VBiasingOperator {
+  /// the configured factor we will use to bias the brem process
+  double factor_;
+  /// energy threshold above which electrons need to be to be biased
+  double threshold_;
+  /// the operation we can give to Geant4 when we want to bias
+  G4BOptnChangeCrossSection* operation_;
+ private:
+  /**
+   * propose a biasing operation that will be used to change the occurence of the physics process
+   * 
+   * @param[in] track stepping through volumes this operator has been attached to
+   * @param[in] callingProcess process that may be happening to the track
+   * @return pointer to operation to use for biasing (0 or nullptr if no biasing should be applied)
+   */
+  virtual G4VBiasingOperation* ProposeOccurenceBiasingOperation(const G4Track* track, const G4BiasingProcessInterface* callingProcess) final;
+  /// return 0 and don't propose final-state biasing
+  virtual G4VBiasingOperation* ProposeFinalStateBiasingOperation(const G4Track*, const G4BiasingProcessInterface*) final;
+  /// return 0 and don't propose non-physics biasing
+  virtual G4VBiasingOperation* ProposeNonPhysicsBiasingOperation(const G4Track*, const G4BiasingProcessInterface*) final;
+ public:
+  /**
+   * Create this biasing operator with the input factor to increase the brem xsec by
+   */
+  BremBiasing(double factor, double threshold);
+  /**
+   * Close up this operator and delete the operation if it exists
+   */
+  virtual ~BremBiasing();
+  /**
+   * Initialize the operator during the start of the run.
+   *
+   * We create the biasing operation if it doesn't exist yet.
+   */
+  virtual void StartRun() final;
+};
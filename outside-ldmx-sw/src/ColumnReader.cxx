@@ -0,0 +1,167 @@
+#include "ColumnReader.h"
+
+#include <stdexcept>
+
+#include "TROOT.h"
+#include "TTree.h"
+
+namespace {
+
+/**
+ * Pointers to the columns of each member of a Particle
+ *
+ * The map nodes in the block are stable so we can look up
+ * the columns once per block instead of once per entry.
+ */
+struct ParticleColumns {
+  std::vector<int> *valid, *track_id, *pdg_id, *parent_id;
+  std::vector<double> *px, *py, *pz, *energy, *x, *y, *z, *t, *weight;
+  ParticleColumns(ColumnReader::Block& block, const std::string& name)
+    : valid{&block.integer[name+".valid"]},
+      track_id{&block.integer[name+".track_id"]},
+      pdg_id{&block.integer[name+".pdg_id"]},
+      parent_id{&block.integer[name+".parent_id"]},
+      px{&block.real[name+".px"]},
+      py{&block.real[name+".py"]},
+      pz{&block.real[name+".pz"]},
+      energy{&block.real[name+".energy"]},
+      x{&block.real[name+".x"]},
+      y{&block.real[name+".y"]},
+      z{&block.real[name+".z"]},
+      t{&block.real[name+".t"]},
+      weight{&block.real[name+".weight"]} {}
+  void reserve(std::size_t n) {
+    for (auto column : {valid, track_id, pdg_id, parent_id}) column->reserve(n);
+    for (auto column : {px, py, pz, energy, x, y, z, t, weight}) column->reserve(n);
+  }
+  /// append the values of a single particle
+  template <typename Leaves>
+  void push_value(Leaves& leaves) {
+    valid->push_back(*leaves.valid);
+    track_id->push_back(*leaves.track_id);
+    pdg_id->push_back(*leaves.pdg_id);
+    parent_id->push_back(*leaves.parent_id);
+    for (auto [column, leaf] : {
+          std::make_pair(px, &leaves.px), std::make_pair(py, &leaves.py),
+          std::make_pair(pz, &leaves.pz), std::make_pair(energy, &leaves.energy),
+          std::make_pair(x, &leaves.x), std::make_pair(y, &leaves.y),
+          std::make_pair(z, &leaves.z), std::make_pair(t, &leaves.t),
+          std::make_pair(weight, &leaves.weight)}) {
+      column->push_back(**leaf);
+    }
+  }
+  /// append the values of a particle collection, returning its size
+  template <typename Leaves>
+  std::size_t push_array(Leaves& leaves) {
+    std::size_t n{leaves.px.GetSize()};
+    for (std::size_t i{0}; i < n; ++i) {
+      valid->push_back(leaves.valid[i]);
+      track_id->push_back(leaves.track_id[i]);
+      pdg_id->push_back(leaves.pdg_id[i]);
+      parent_id->push_back(leaves.parent_id[i]);
+    }
+    for (auto [column, leaf] : {
+          std::make_pair(px, &leaves.px), std::make_pair(py, &leaves.py),
+          std::make_pair(pz, &leaves.pz), std::make_pair(energy, &leaves.energy),
+          std::make_pair(x, &leaves.x), std::make_pair(y, &leaves.y),
+          std::make_pair(z, &leaves.z), std::make_pair(t, &leaves.t),
+          std::make_pair(weight, &leaves.weight)}) {
+      column->insert(column->end(), leaf->begin(), leaf->end());
+    }
+    return n;
+  }
+};
+
+/// enable ROOT's thread safety and then open the file, throwing if it cannot be opened
+TFile* open(const std::string& filepath) {
+  // the read-ahead task uses ROOT I/O while the caller may be using ROOT as well
+  ROOT::EnableThreadSafety();
+  TFile* file{TFile::Open(filepath.c_str())};
+  if (file == nullptr or not file->IsOpen()) {
+    delete file;
+    throw std::runtime_error("Unable to open '"+filepath+"'.");
+  }
+  return file;
+}
+
+}  // namespace
+
+ColumnReader::ColumnReader(const std::string& filepath, Long64_t block_size)
+  : file_{open(filepath)},
+    reader_{"events", file_.get()},
+    incident_{reader_, "incident"},
+    parent_{reader_, "parent"},
+    mu_plus_{reader_, "mu_plus"},
+    mu_minus_{reader_, "mu_minus"},
+    extra_{reader_, "extra"},
+    ecal_{reader_, "ecal"},
+    weight_{reader_, "weight"} {
+  TTree* tree{reader_.GetTree()};
+  if (tree == nullptr) {
+    throw std::runtime_error("'"+filepath+"' does not have an events tree.");
+  }
+  Long64_t entries{tree->GetEntries()};
+  if (block_size > 0) {
+    for (Long64_t start{0}; start < entries; start += block_size) boundaries_.push_back(start);
+  } else {
+    auto clusters{tree->GetClusterIterator(0)};
+    for (Long64_t start{clusters()}; start < entries; start = clusters()) boundaries_.push_back(start);
+  }
+  boundaries_.push_back(entries);
+  read_ahead();
+}
+
+ColumnReader::~ColumnReader() {
+  if (next_.valid()) next_.wait();
+}
+
+std::unique_ptr<ColumnReader::Block> ColumnReader::read() {
+  auto block{std::make_unique<Block>()};
+  block->first = boundaries_[i_next_block_];
+  block->entries = boundaries_[i_next_block_+1] - block->first;
+  ++i_next_block_;
+
+  std::vector<std::pair<Leaves<TTreeReaderValue>*, ParticleColumns>> singles;
+  for (auto [name, value] : {
+        std::make_pair("incident", &incident_),
+        std::make_pair("parent", &parent_),
+        std::make_pair("mu_plus", &mu_plus_),
+        std::make_pair("mu_minus", &mu_minus_)}) {
+    singles.emplace_back(value, ParticleColumns(*block, name));
+    singles.back().second.reserve(block->entries);
+  }
+  std::vector<std::tuple<Leaves<TTreeReaderArray>*, ParticleColumns, std::vector<Long64_t>*>> collections;
+  for (auto [name, value] : {
+        std::make_pair("extra", &extra_),
+        std::make_pair("ecal", &ecal_)}) {
+    auto& offsets{block->offsets[name]};
+    offsets.reserve(block->entries+1);
+    offsets.push_back(0);
+    collections.emplace_back(value, ParticleColumns(*block, name), &offsets);
+  }
+  auto& weight{block->real["weight"]};
+  weight.reserve(block->entries);
+
+  reader_.Restart();
+  reader_.SetEntriesRange(block->first, block->first+block->entries);
+  while (reader_.Next()) {
+    for (auto& [leaves, columns] : singles) columns.push_value(*leaves);
+    for (auto& [leaves, columns, offsets] : collections) {
+      offsets->push_back(offsets->back() + columns.push_array(*leaves));
+    }
+    weight.push_back(*weight_);
+  }
+  return block;
+}
+
+void ColumnReader::read_ahead() {
+  if (i_next_block_+1 >= boundaries_.size()) return;
+  next_ = std::async(std::launch::async, [this]() { return read(); });
+}
+
+ColumnReader::Block* ColumnReader::next() {
+  if (not next_.valid()) return nullptr;
+  std::unique_ptr<Block> block{next_.get()};
+  read_ahead();
+  return block.release();
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <future>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "TFile.h"
+#include "TTreeReader.h"
+#include "TTreeReaderArray.h"
+#include "TTreeReaderValue.h"
+
+/**
+ * Read the events tree into contiguous columns
+ *
+ * Each member of the particles in the events tree is read into its own
+ * contiguous column so that the memory can be viewed directly by NumPy
+ * without copying. Particle collections (extra and ecal) have their members
+ * flattened into columns across the events alongside an offsets column
+ * of length entries+1 giving the start of each event.
+ *
+ * The particle branches are split, so we read each member from its own
+ * leaf branch (e.g. "mu_plus.px") instead of deserializing whole Particles.
+ * Only the baskets of those leaves are decoded and their values are
+ * appended to the columns directly.
+ *
+ * The entries are read in blocks following the clusters of the tree by default.
+ * While one block is being used, the next block is read in a background task.
+ *
+ * Columns are named "{branch}.{member}" (e.g. "mu_plus.px") and the
+ * offsets are named by the branch (e.g. "extra").
+ */
+class ColumnReader {
+ public:
+  /// a block of entries read into columns
+  struct Block {
+    /// entry number of the first entry in this block
+    Long64_t first{0};
+    /// number of entries in this block
+    Long64_t entries{0};
+    /// floating point columns
+    std::map<std::string, std::vector<double>> real;
+    /// integer columns
+    std::map<std::string, std::vector<int>> integer;
+    /// offsets of the particle collections
+    std::map<std::string, std::vector<Long64_t>> offsets;
+  };
+ private:
+  /**
+   * readers of the leaves of each member of a particle branch
+   *
+   * @tparam Reader TTreeReaderValue for single particles and
+   * TTreeReaderArray for particle collections
+   */
+  template <template <typename> class Reader>
+  struct Leaves {
+    Reader<bool> valid;
+    Reader<int> track_id, pdg_id, parent_id;
+    Reader<double> px, py, pz, energy, x, y, z, t, weight;
+    Leaves(TTreeReader& reader, const std::string& branch)
+      : valid{reader, (branch+".valid").c_str()},
+        track_id{reader, (branch+".track_id").c_str()},
+        pdg_id{reader, (branch+".pdg_id").c_str()},
+        parent_id{reader, (branch+".parent_id").c_str()},
+        px{reader, (branch+".px").c_str()},
+        py{reader, (branch+".py").c_str()},
+        pz{reader, (branch+".pz").c_str()},
+        energy{reader, (branch+".energy").c_str()},
+        x{reader, (branch+".x").c_str()},
+        y{reader, (branch+".y").c_str()},
+        z{reader, (branch+".z").c_str()},
+        t{reader, (branch+".t").c_str()},
+        weight{reader, (branch+".weight").c_str()} {}
+  };
+  /// file we are reading from
+  std::unique_ptr<TFile> file_; //!
+  /// reader of the events tree, only touched by the read-ahead task
+  TTreeReader reader_; //!
+  /// the single particle branches
+  Leaves<TTreeReaderValue> incident_, parent_, mu_plus_, mu_minus_; //!
+  /// the particle collection branches
+  Leaves<TTreeReaderArray> extra_, ecal_; //!
+  /// the event weight
+  TTreeReaderValue<double> weight_; //!
+  /// entry numbers starting each block with the total number of entries at the end
+  std::vector<Long64_t> boundaries_; //!
+  /// index of next block to read
+  std::size_t i_next_block_{0}; //!
+  /// read-ahead of the next block
+  std::future<std::unique_ptr<Block>> next_; //!
+  /// read the next block from the file
+  std::unique_ptr<Block> read();
+  /// start reading the next block in the background if there is one
+  void read_ahead();
+ public:
+  /**
+   * Open the file and start reading the first block
+   *
+   * The read-ahead task uses ROOT I/O while the caller may be using ROOT
+   * as well, so ROOT's thread safety is enabled before the file is opened.
+   * Callers that create other ROOT objects first should enable it themselves.
+   *
+   * @throws std::runtime_error if the file cannot be opened or has no events tree
+   * @param[in] filepath path to dimuon-simulate output file
+   * @param[in] block_size number of entries per block, 0 means follow the clusters of the tree
+   */
+  ColumnReader(const std::string& filepath, Long64_t block_size = 0);
+  /// wait for any outstanding read before closing
+  ~ColumnReader();
+  /// total number of entries in the events tree
+  Long64_t entries() const {
+    return boundaries_.back();
+  }
+  /**
+   * Get the next block of entries
+   *
+   * The caller takes ownership of the block.
+   *
+   * @return next block, nullptr if there are no more blocks
+   */
+  Block* next();
+};
@@ -0,0 +1,28 @@
+#include "CombinedBiasing.h"
+
+#include "G4Track.hh"
+
+G4VBiasingOperator* CombinedBiasing::find(const G4Track* track) const {
+  auto it{operators_.find(track->GetDefinition())};
+  return (it == operators_.end() ? nullptr : it->second);
+}
+G4VBiasingOperation* CombinedBiasing::ProposeOccurenceBiasingOperation(const G4Track* track, const G4BiasingProcessInterface* callingProcess) {
+  G4VBiasingOperator* op{find(track)};
+  return (op ? op->GetProposedOccurenceBiasingOperation(track, callingProcess) : 0);
+}
+G4VBiasingOperation* CombinedBiasing::ProposeFinalStateBiasingOperation(const G4Track* track, const G4BiasingProcessInterface* callingProcess) {
+  G4VBiasingOperator* op{find(track)};
+  return (op ? op->GetProposedFinalStateBiasingOperation(track, callingProcess) : 0);
+}
+G4VBiasingOperation* CombinedBiasing::ProposeNonPhysicsBiasingOperation(const G4Track* track, const G4BiasingProcessInterface* callingProcess) {
+  G4VBiasingOperator* op{find(track)};
+  return (op ? op->GetProposedNonPhysicsBiasingOperation(track, callingProcess) : 0);
+}
+CombinedBiasing::CombinedBiasing()
+  : G4VBiasingOperator("bias-combined") {}
+CombinedBiasing::~CombinedBiasing() {
+  for (auto& [particle, op] : operators_) delete op;
+}
+void CombinedBiasing::add(const G4ParticleDefinition* particle, G4VBiasingOperator* op) {
+  operators_[particle] = op;
+}
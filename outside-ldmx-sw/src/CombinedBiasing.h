@@ -0,0 +1,42 @@
+#pragma once
+
+#include <map>
+
+#include "G4ParticleDefinition.hh"
+#include "G4VBiasingOperator.hh"
+
+/**
+ * combine biasing operators acting on different particles in the same volume
+ *
+ * Geant4 only allows a single biasing operator to be attached to a logical
+ * volume, so this operator is attached instead and it delegates to the operator
+ * configured for the particle of the track being stepped.
+ * The delegated operators are not attached to any volume themselves.
+ */
+class CombinedBiasing : public G4VBiasingOperator {
+  /// the operator to delegate to for each particle
+  std::map<const G4ParticleDefinition*, G4VBiasingOperator*> operators_;
+  /// the operator for the particle of the input track, nullptr if there isn't one
+  G4VBiasingOperator* find(const G4Track* track) const;
+ private:
+  /// delegate occurence biasing to the operator for this particle
+  virtual G4VBiasingOperation* ProposeOccurenceBiasingOperation(const G4Track* track, const G4BiasingProcessInterface* callingProcess) final;
+  /// delegate final-state biasing to the operator for this particle
+  virtual G4VBiasingOperation* ProposeFinalStateBiasingOperation(const G4Track* track, const G4BiasingProcessInterface* callingProcess) final;
+  /// delegate non-physics biasing to the operator for this particle
+  virtual G4VBiasingOperation* ProposeNonPhysicsBiasingOperation(const G4Track* track, const G4BiasingProcessInterface* callingProcess) final;
+ public:
+  /// create an operator without any delegates
+  CombinedBiasing();
+  /// delete the operators we delegate to
+  virtual ~CombinedBiasing();
+  /**
+   * Delegate the biasing of the input particle to the input operator
+   *
+   * We take ownership of the operator.
+   *
+   * @param[in] particle definition of particle to delegate
+   * @param[in] op operator to delegate to
+   */
+  void add(const G4ParticleDefinition* particle, G4VBiasingOperator* op);
+};
@@ -0,0 +1,109 @@
+#include "EventIndex.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+
+#include "TTreeReader.h"
+#include "TTreeReaderValue.h"
+
+#include "Kinematics.h"
+
+namespace event_index {
+
+const std::vector<std::string> KEYS = {
+  "mu_max_energy",
+  "mu_min_energy",
+  "pair_mass",
+  "mu_max_ecal_radius"
+};
+
+void build(TTree* events, TDirectory* out) {
+  TTreeReader reader(events);
+  TTreeReaderValue<Particle> mu_plus(reader, "mu_plus"), mu_minus(reader, "mu_minus");
+  TTreeReaderValue<std::vector<Particle>> ecal(reader, "ecal");
+
+  std::vector<Long64_t> entries;
+  std::vector<std::vector<double>> values(KEYS.size());
+  while (reader.Next()) {
+    if (not mu_plus->is_valid() or not mu_minus->is_valid()) continue;
+    entries.push_back(reader.GetCurrentEntry());
+    double e_plus{mu_plus->total_energy()}, e_minus{mu_minus->total_energy()};
+    values[0].push_back(std::max(e_plus, e_minus));
+    values[1].push_back(std::min(e_plus, e_minus));
+    values[2].push_back(kinematics::pair_mass(*mu_plus, *mu_minus));
+    double radius{std::numeric_limits<double>::infinity()};
+    const Particle* hit_plus{kinematics::find_hit(*ecal, mu_plus->id())};
+    const Particle* hit_minus{kinematics::find_hit(*ecal, mu_minus->id())};
+    if (hit_plus and hit_minus) {
+      radius = std::max(kinematics::radius(*hit_plus), kinematics::radius(*hit_minus));
+    }
+    values[3].push_back(radius);
+  }
+
+  out->cd();
+  std::vector<std::size_t> order(entries.size());
+  for (std::size_t i_key{0}; i_key < KEYS.size(); ++i_key) {
+    const std::vector<double>& key_values{values[i_key]};
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+      return key_values[a] < key_values[b];
+    });
+    double value;
+    Long64_t entry;
+    TTree index(("index_"+KEYS[i_key]).c_str(), ("sorted index of "+KEYS[i_key]).c_str());
+    index.Branch("value", &value, "value/D");
+    index.Branch("entry", &entry, "entry/L");
+    for (std::size_t i : order) {
+      value = key_values[i];
+      entry = entries[i];
+      index.Fill();
+    }
+    index.Write(nullptr, TObject::kOverwrite);
+  }
+}
+
+std::unique_ptr<TEntryList> select(TDirectory* dir, const std::string& key, double low, double high) {
+  auto index{dir->Get<TTree>(("index_"+key).c_str())};
+  if (not index) {
+    throw std::runtime_error("No index for '"+key+"', has dimuon-index been run on this file?");
+  }
+  double value;
+  Long64_t entry;
+  index->SetBranchAddress("value", &value);
+  index->SetBranchAddress("entry", &entry);
+
+  // find the first index entry with a value not less than the input bound
+  auto lower_bound = [&](double bound) {
+    Long64_t first{0}, count{index->GetEntries()};
+    while (count > 0) {
+      Long64_t step{count/2};
+      index->GetEntry(first+step);
+      if (value < bound) {
+        first += step+1;
+        count -= step+1;
+      } else {
+        count = step;
+      }
+    }
+    return first;
+  };
+  Long64_t begin{lower_bound(low)}, end{lower_bound(high)};
+
+  std::vector<Long64_t> selected;
+  selected.reserve(std::max(Long64_t{0}, end-begin));
+  for (Long64_t i{begin}; i < end; ++i) {
+    index->GetEntry(i);
+    selected.push_back(entry);
+  }
+  // reading in entry order is much faster than reading in value order
+  std::sort(selected.begin(), selected.end());
+
+  auto list{std::make_unique<TEntryList>(key.c_str(), key.c_str())};
+  list->SetTree(dir->Get<TTree>("events"));
+  for (Long64_t e : selected) list->Enter(e);
+  return list;
+}
+
+}  // namespace event_index
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "TDirectory.h"
+#include "TEntryList.h"
+#include "TTree.h"
+
+/**
+ * Sorted side indices of the events for fast selection
+ *
+ * For each key, we store a tree named "index_{key}" next to the events
+ * holding the value of that key and the entry number in the events tree
+ * sorted by the value. Selecting a range of values is then a binary search
+ * followed by reading only the matching part of the index.
+ *
+ * Only events with a muon-conversion are indexed.
+ *
+ * Keys
+ * - mu_max_energy : maximum total energy of the two muons [MeV]
+ * - mu_min_energy : minimum total energy of the two muons [MeV]
+ * - pair_mass : invariant mass of the two muons [MeV]
+ * - mu_max_ecal_radius : maximum distance from the beam axis of the two muons
+ *   at the ECal scoring plane [mm], infinite if either muon misses the plane
+ */
+namespace event_index {
+
+/// the keys we index
+extern const std::vector<std::string> KEYS;
+
+/**
+ * Build the indices of the input events tree
+ *
+ * @param[in] events tree of events to index
+ * @param[in] out directory to write the index trees into (overwriting any old ones)
+ */
+void build(TTree* events, TDirectory* out);
+
+/**
+ * Select the entries with the input key in the range [low, high)
+ *
+ * @param[in] dir directory holding the events and its indices
+ * @param[in] key name of key to select on
+ * @param[in] low lower (inclusive) bound of key value
+ * @param[in] high upper (exclusive) bound of key value
+ * @return list of selected entries in the events tree
+ */
+std::unique_ptr<TEntryList> select(TDirectory* dir, const std::string& key, double low, double high);
+
+}  // namespace event_index
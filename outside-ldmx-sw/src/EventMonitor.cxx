@@ -0,0 +1,92 @@
+#include "EventMonitor.h"
+
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "G4EventManager.hh"
+#include "G4RunManager.hh"
+#include "G4StackManager.hh"
+
+#include "Memory.h"
+
+/// number of tracks to classify between checks of the resident memory
+static const long unsigned int RSS_CHECK_PERIOD = 4096;
+
+/**
+ * book a histogram with logarithmic bins
+ *
+ * The counts we monitor span many orders of magnitude from event to event,
+ * so we use ten bins per decade. The bins are fixed so that histograms
+ * from different runs can be added together.
+ */
+static TH1D log_histogram(const char* name, const char* title, double max) {
+  std::vector<double> edges{0.};
+  int n_bins = std::lround(10*std::log10(max));
+  for (int i{0}; i <= n_bins; ++i) edges.push_back(std::pow(10., i/10.));
+  TH1D h(name, title, edges.size()-1, edges.data());
+  // we own the histogram, not whatever ROOT directory happens to be open
+  h.SetDirectory(nullptr);
+  return h;
+}
+
+EventMonitor::EventMonitor(std::optional<long unsigned int> max_stack, std::optional<double> max_rss)
+  : max_stack_{max_stack},
+    max_rss_{max_rss},
+    peak_stack_hist_{log_histogram("event_peak_stack", ";Peak Tracks on Stacks;Events", 1e8)},
+    tracks_hist_{log_histogram("event_tracks_created", ";Tracks Created;Events", 1e8)},
+    extra_hist_{log_histogram("event_extra_size", ";Particles Leaving Target;Events", 1e6)},
+    ecal_hist_{log_histogram("event_ecal_size", ";Particles Entering ECal;Events", 1e6)},
+    rss_hist_{log_histogram("event_rss", ";Resident Memory at End of Event [MB];Events", 1e6)},
+    aborted_{"monitor_aborted", "Events Aborted by Resource Limits;Limit;Events", 2, 0., 2.} {
+  aborted_.SetDirectory(nullptr);
+  aborted_.GetXaxis()->SetBinLabel(1, "max-stack");
+  aborted_.GetXaxis()->SetBinLabel(2, "max-rss");
+}
+
+void EventMonitor::BeginOfEventAction(const G4Event*) {
+  peak_stack_ = 0;
+  max_track_id_ = 0;
+  aborted_event_ = false;
+}
+
+bool EventMonitor::ClassifyNewTrack(const G4Track* track) {
+  // the rest of the step that went over a limit may still create tracks
+  if (aborted_event_) return true;
+  if (track->GetTrackID() > max_track_id_) max_track_id_ = track->GetTrackID();
+  long unsigned int stacked = G4EventManager::GetEventManager()->GetStackManager()->GetNTotalTrack();
+  if (stacked > peak_stack_) peak_stack_ = stacked;
+
+  if (max_stack_ and stacked > max_stack_.value()) {
+    std::cerr << "[ dimuon-simulate ]: Aborting event with more than "
+      << max_stack_.value() << " tracks on the stacks." << std::endl;
+    aborted_.Fill(0);
+    aborted_event_ = true;
+    G4RunManager::GetRunManager()->AbortEvent();
+    return true;
+  }
+
+  if (max_rss_ and ++since_rss_check_ >= RSS_CHECK_PERIOD) {
+    since_rss_check_ = 0;
+    double rss{memory::resident_set_size()};
+    if (rss > max_rss_.value()) {
+      std::cerr << "[ dimuon-simulate ]: Ending run since resident memory " << rss
+        << " MB is above the limit of " << max_rss_.value() << " MB." << std::endl;
+      aborted_.Fill(1);
+      ended_run_ = true;
+      aborted_event_ = true;
+      G4RunManager::GetRunManager()->AbortRun(true);
+      G4RunManager::GetRunManager()->AbortEvent();
+      return true;
+    }
+  }
+  return false;
+}
+
+void EventMonitor::EndOfEventAction(std::size_t n_extra, std::size_t n_ecal) {
+  peak_stack_hist_.Fill(peak_stack_);
+  tracks_hist_.Fill(max_track_id_);
+  extra_hist_.Fill(n_extra);
+  ecal_hist_.Fill(n_ecal);
+  rss_hist_.Fill(memory::resident_set_size());
+}
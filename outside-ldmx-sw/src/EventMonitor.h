@@ -0,0 +1,92 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include "G4Event.hh"
+#include "G4Track.hh"
+
+#include "TH1D.h"
+
+/**
+ * monitor the resources each event uses and enforce limits on them
+ *
+ * For every event (kept or not), we record the peak number of tracks
+ * waiting on the stacks, the number of tracks created, the number of
+ * particles recorded leaving the target and entering the ECal, and the
+ * resident memory of the process at the end of the event. These are
+ * filled into run-level histograms so batch jobs can be sized.
+ *
+ * If a stack limit is set, events whose stacks grow beyond it are aborted.
+ * If a memory limit is set and the process grows beyond it, the current
+ * event is aborted and the run is ended after it so the output file is
+ * closed properly instead of the job being killed.
+ */
+class EventMonitor {
+  /// maximum number of tracks on the stacks before aborting the event
+  std::optional<long unsigned int> max_stack_;
+  /// maximum resident memory in MB before ending the run
+  std::optional<double> max_rss_;
+  /// peak number of tracks on the stacks in this event
+  long unsigned int peak_stack_{0};
+  /// largest track ID in this event, which is the number of tracks created
+  int max_track_id_{0};
+  /// number of tracks classified since memory was last checked
+  long unsigned int since_rss_check_{0};
+  /// the per-event histograms
+  TH1D peak_stack_hist_, tracks_hist_, extra_hist_, ecal_hist_, rss_hist_;
+  /// number of events aborted by each limit
+  TH1D aborted_;
+  /// true if we ended the run because of the memory limit
+  bool ended_run_{false};
+  /// true if we aborted the current event
+  bool aborted_event_{false};
+ public:
+  /**
+   * Set the limits and book the histograms
+   *
+   * @param[in] max_stack maximum number of tracks on the stacks, if set
+   * @param[in] max_rss maximum resident memory in MB, if set
+   */
+  EventMonitor(std::optional<long unsigned int> max_stack, std::optional<double> max_rss);
+
+  /**
+   * Reset the per-event counters
+   *
+   * @param[in] event unused
+   */
+  void BeginOfEventAction(const G4Event* event);
+
+  /**
+   * Update the per-event counters and check the limits
+   *
+   * @param[in] track new track being classified
+   * @return true if the event was aborted and the track should be killed
+   */
+  bool ClassifyNewTrack(const G4Track* track);
+
+  /**
+   * Fill the per-event histograms
+   *
+   * @param[in] n_extra number of particles recorded leaving the target
+   * @param[in] n_ecal number of particles recorded entering the ECal
+   */
+  void EndOfEventAction(std::size_t n_extra, std::size_t n_ecal);
+
+  /// check if the run was ended because of the memory limit
+  bool ended_run() const {
+    return ended_run_;
+  }
+
+  /// check if the current event was aborted by one of the limits, leaving its shower incomplete
+  bool aborted_event() const {
+    return aborted_event_;
+  }
+
+  /**
+   * Get the histograms so they can be written to the output file
+   */
+  std::vector<const TH1D*> histograms() const {
+    return {&peak_stack_hist_, &tracks_hist_, &extra_hist_, &ecal_hist_, &rss_hist_, &aborted_};
+  }
+};
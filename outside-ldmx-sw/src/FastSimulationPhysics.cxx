@@ -0,0 +1,23 @@
+#include "FastSimulationPhysics.h"
+
+#include "G4Electron.hh"
+#include "G4Gamma.hh"
+#include "G4Positron.hh"
+#include "G4ProcessManager.hh"
+
+void FastSimulationPhysics::ConstructParticle() {}
+
+void FastSimulationPhysics::ConstructProcess() {
+  for (G4ParticleDefinition* particle : {
+      static_cast<G4ParticleDefinition*>(G4Gamma::Gamma()),
+      static_cast<G4ParticleDefinition*>(G4Electron::Electron()),
+      static_cast<G4ParticleDefinition*>(G4Positron::Positron())}) {
+    processes_.push_back(std::make_unique<G4FastSimulationManagerProcess>("fastSim"));
+    G4int ret = particle->GetProcessManager()->AddDiscreteProcess(processes_.back().get());
+    if (ret < 0) {
+      throw std::runtime_error(
+          "Error attempting to register the fast simulation process for "
+          +particle->GetParticleName()+". Code: "+std::to_string(ret));
+    }
+  }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "G4VPhysicsConstructor.hh"
+#include "G4FastSimulationManagerProcess.hh"
+
+/**
+ * basic physics constructor which attaches the fast simulation process
+ * to electrons, positrons, and photons
+ *
+ * This is necessary for any G4VFastSimulationModel attached to a region
+ * (e.g. the LeakageModel in the hunk) to be given a chance to replace
+ * these particles.
+ */
+class FastSimulationPhysics : public G4VPhysicsConstructor {
+  /// handles to the processes, cleaned up when the physics list is destructed
+  std::vector<std::unique_ptr<G4FastSimulationManagerProcess>> processes_;
+ public:
+  /// create the physics
+  FastSimulationPhysics() = default;
+
+  /**
+   * We don't construct any particles since we are just
+   * attaching a new process to existing particles
+   */
+  void ConstructParticle() final override;
+
+  /**
+   * Construct a fast simulation process for each particle
+   *
+   * We own the processes and clean them up when the physics constructor
+   * is cleaned up by Geant4 after registration.
+   */
+  void ConstructProcess() final override;
+};
@@ -4,13 +4,17 @@
 #include "G4Box.hh"
 #include "G4PVPlacement.hh"
 #include "G4LogicalVolume.hh"
+#include "G4FastSimulationManager.hh"
+#include "G4Region.hh"
 
-Hunk::Hunk(double depth, const std::string& material, ScoringPlaneSD* ecal, MuonConversionBiasing* muon_conv_bias)
+Hunk::Hunk(double depth, const std::string& material, ScoringPlaneSD* ecal, G4VBiasingOperator* biasing,
+    G4VFastSimulationModel* fast)
   : G4VUserDetectorConstruction(),
     depth_{depth},
     material_{material},
     ecal_{ecal},
-    muon_conversion_biasing_{muon_conv_bias}
+    biasing_{biasing},
+    fast_{fast}
 {}
 
 G4VPhysicalVolume* Hunk::Construct() {
@@ -18,8 +22,8 @@ G4VPhysicalVolume* Hunk::Construct() {
   G4NistManager* nist = G4NistManager::Instance();
   using CLHEP::mm;
 
-  G4double box_half_x{500*mm},
-           box_half_y{500*mm},
+  G4double box_half_x{HALF_WIDTH*mm},
+           box_half_y{HALF_WIDTH*mm},
            box_half_z{depth_/2*mm};
   G4Material* box_mat = nist->FindOrBuildMaterial(material_);
   if (not box_mat) {
@@ -31,7 +35,7 @@ G4VPhysicalVolume* Hunk::Construct() {
     throw std::runtime_error("Material 'G4_AIR' unknown to G4NistManager.");
   }
 
-  static const double ecal_sp = 240*mm;
+  static const double ecal_sp = ECAL_SP_Z*mm;
   G4double world_half_z = (1+depth_+ecal_sp+1);
   G4Box* solidWorld =
     new G4Box("World", 1.1*box_half_x, 1.1*box_half_y, world_half_z);
@@ -56,7 +60,13 @@ G4VPhysicalVolume* Hunk::Construct() {
 
   G4LogicalVolume* logicBox = new G4LogicalVolume(solidBox,
       box_mat, "Hunk");
-  if (muon_conversion_biasing_) muon_conversion_biasing_->AttachTo(logicBox);
+  if (biasing_) biasing_->AttachTo(logicBox);
+  if (fast_) {
+    // fast simulation models are attached to regions rather than volumes
+    G4Region* region = new G4Region("Hunk");
+    region->AddRootLogicalVolume(logicBox);
+    (new G4FastSimulationManager(region))->AddFastSimulationModel(fast_);
+  }
 
   // providing mother volume attaches us to the world volume
   new G4PVPlacement(0, //no rotation
@@ -69,7 +79,7 @@ G4VPhysicalVolume* Hunk::Construct() {
       false);          //overlaps checking
  
   G4Box* solidScoringPlane = new G4Box("ScoringPlane",
-      box_half_x, box_half_y, 1*mm);
+      box_half_x, box_half_y, ECAL_SP_HALF_THICKNESS*mm);
 
   G4LogicalVolume* ecalScoringPlane = new G4LogicalVolume(solidScoringPlane,
       world_mat, "EcalScoringPlane");
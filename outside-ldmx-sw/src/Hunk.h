@@ -3,7 +3,8 @@
 #include "G4VUserDetectorConstruction.hh"
 
 #include "ScoringPlaneSD.h"
-#include "MuonConversionBiasing.h"
+#include "G4VBiasingOperator.hh"
+#include "G4VFastSimulationModel.hh"
 
 /**
  * basic 'hunk' of material in air, the material and its thickness is configurable
@@ -18,13 +19,22 @@ class Hunk : public G4VUserDetectorConstruction {
   std::string material_;
   /// pointer to SD for ECal scoring plane
   ScoringPlaneSD* ecal_;
-  /// pointer to biasing operator for muon conversion (if we are biasing)
-  MuonConversionBiasing* muon_conversion_biasing_;
+  /// pointer to biasing operator for the hunk (if we are biasing)
+  G4VBiasingOperator* biasing_;
+  /// pointer to fast simulation model for the hunk (if we are using one)
+  G4VFastSimulationModel* fast_;
  public:
+  /// transverse half-width of the hunk and the ECal scoring plane [mm]
+  static constexpr double HALF_WIDTH = 500.;
+  /// location of the center of the ECal scoring plane along the beam axis [mm]
+  static constexpr double ECAL_SP_Z = 240.;
+  /// half-thickness of the ECal scoring plane along the beam axis [mm]
+  static constexpr double ECAL_SP_HALF_THICKNESS = 1.;
   /**
    * Create our detector constructor, storing the configuration variables
    */
-  Hunk(double depth, const std::string& material, ScoringPlaneSD* ecal, MuonConversionBiasing* muon_conv_bias);
+  Hunk(double depth, const std::string& material, ScoringPlaneSD* ecal, G4VBiasingOperator* biasing,
+      G4VFastSimulationModel* fast = nullptr);
 
   /**
    * Construct the geometry
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <cmath>
+
+#include "Math/VectorUtil.h"
+
+#include "Particle.h"
+
+/**
+ * Derived kinematic quantities shared between the different analyses
+ * of our events so they are all calculated the same way.
+ */
+namespace kinematics {
+
+/**
+ * invariant mass of the pair of particles [MeV]
+ */
+inline double pair_mass(const Particle& a, const Particle& b) {
+  return (a.momentum()+b.momentum()).M();
+}
+
+/**
+ * angle between the momenta of the pair of particles [rad]
+ */
+inline double opening_angle(const Particle& a, const Particle& b) {
+  return ROOT::Math::VectorUtil::Angle(a.momentum(), b.momentum());
+}
+
+/**
+ * find the scoring plane hit of the input track
+ *
+ * The collection of hits is any container of Particles
+ * (e.g. std::vector or ROOT::RVec).
+ *
+ * @return pointer to the first hit from the track, nullptr if there isn't one
+ */
+template <typename Hits>
+const Particle* find_hit(const Hits& hits, int track_id) {
+  for (const Particle& hit : hits) {
+    if (hit.id() == track_id) return &hit;
+  }
+  return nullptr;
+}
+
+/**
+ * transverse distance from the beam axis [mm]
+ */
+inline double radius(const Particle& p) {
+  auto position{p.position()};
+  return std::hypot(position.X(), position.Y());
+}
+
+}  // namespace kinematics
@@ -0,0 +1,100 @@
+#include "LeakageModel.h"
+
+#include <cmath>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+
+#include "G4DynamicParticle.hh"
+#include "G4Electron.hh"
+#include "G4FastStep.hh"
+#include "G4FastTrack.hh"
+#include "G4Gamma.hh"
+#include "G4Positron.hh"
+#include "G4VProcess.hh"
+#include "Randomize.hh"
+
+#include "TFile.h"
+
+#include "RunHeader.h"
+
+/// distance inside the faces of the hunk to place the created particles [mm]
+static const double FACE_OFFSET = 1e-6;
+
+/// the particle definition of each tabulated species
+static const G4ParticleDefinition* definition(LeakageTable::Species species) {
+  switch (species) {
+    case LeakageTable::Photon: return G4Gamma::Gamma();
+    case LeakageTable::Electron: return G4Electron::Electron();
+    default: return G4Positron::Positron();
+  }
+}
+
+LeakageModel::LeakageModel(const std::string& filepath, const std::string& target, double depth)
+  : G4VFastSimulationModel("leakage"), table_{filepath}, depth_{depth} {
+  std::unique_ptr<RunHeader> rh;
+  {
+    TFile f{filepath.c_str()};
+    rh.reset(f.Get<RunHeader>("run"));
+  }
+  if (not rh) {
+    throw std::runtime_error("Leakage model '"+filepath+"' does not have a run header to check its target against.");
+  }
+  // the depth axis of the table is clamped, so a different target would be sampled silently
+  if (rh->target() != target or std::abs(rh->depth()-depth) > 1e-6*depth) {
+    std::stringstream msg;
+    msg << "Leakage model '" << filepath << "' was trained in " << rh->depth() << " mm of " << rh->target()
+      << " but this run has " << depth << " mm of " << target << ".";
+    throw std::runtime_error(msg.str());
+  }
+  std::stringstream description;
+  description << filepath << " below " << table_.max_energy() << " MeV";
+  description_ = description.str();
+}
+
+LeakageModel::~LeakageModel() {
+  std::cout
+    << "[ dimuon-simulate ]: Leakage model replaced " << replaced_
+    << " tracks with " << created_ << " particles leaving the target."
+    << std::endl;
+}
+
+G4bool LeakageModel::IsApplicable(const G4ParticleDefinition& particle) {
+  return LeakageTable::species(particle.GetPDGEncoding()) != LeakageTable::NumSpecies;
+}
+
+G4bool LeakageModel::ModelTrigger(const G4FastTrack& fast_track) {
+  const G4Track* track{fast_track.GetPrimaryTrack()};
+  if (track->GetKineticEnergy() >= table_.max_energy()) return false;
+  const G4VProcess* creator{track->GetCreatorProcess()};
+  return creator == nullptr or creator->GetProcessType() != fParameterisation;
+}
+
+void LeakageModel::DoIt(const G4FastTrack& fast_track, G4FastStep& fast_step) {
+  const G4Track* track{fast_track.GetPrimaryTrack()};
+  double energy{track->GetKineticEnergy()};
+  G4ThreeVector position{track->GetPosition()};
+  auto leaks{table_.sample(
+      LeakageTable::species(track->GetDefinition()->GetPDGEncoding()),
+      energy, -position.z())};
+
+  fast_step.KillPrimaryTrack();
+  fast_step.ProposePrimaryTrackPathLength(0.);
+  fast_step.SetNumberOfSecondaryTracks(leaks.size());
+  double leaked{0.};
+  for (const LeakageTable::Leak& leak : leaks) {
+    double phi{CLHEP::twopi*G4UniformRand()};
+    double sin_theta{std::sqrt(std::max(0., 1.-leak.cos_theta*leak.cos_theta))};
+    G4ThreeVector direction{sin_theta*std::cos(phi), sin_theta*std::sin(phi), leak.cos_theta};
+    G4ThreeVector where{position.x(), position.y(),
+      leak.cos_theta >= 0. ? -FACE_OFFSET : -depth_+FACE_OFFSET};
+    G4DynamicParticle particle(definition(leak.species), direction, leak.energy);
+    G4Track* secondary{fast_step.CreateSecondaryTrack(particle, where, track->GetGlobalTime(), false)};
+    secondary->SetWeight(track->GetWeight());
+    leaked += leak.energy;
+  }
+  fast_step.ProposeTotalEnergyDeposited(std::max(0., energy-leaked));
+  ++replaced_;
+  created_ += leaks.size();
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <string>
+
+#include "G4VFastSimulationModel.hh"
+
+#include "LeakageTable.h"
+
+/**
+ * replace the low-energy electromagnetic shower in the hunk with its leakage
+ *
+ * Electrons, positrons, and photons in the hunk below the maximum energy of
+ * a trained LeakageTable are killed at the start of their step, depositing their
+ * energy. In their place, we create the particles their shower would have
+ * sent out of the hunk as sampled from the table. These are placed just inside
+ * the downstream (upstream) face of the hunk if they are heading downstream
+ * (upstream) at the transverse position of the replaced track so that they
+ * are recorded leaving the hunk like any other particle.
+ *
+ * The particles we create have the weight of the track they replace and
+ * are not replaced themselves.
+ */
+class LeakageModel : public G4VFastSimulationModel {
+  /// the trained table we sample from
+  LeakageTable table_;
+  /// depth of the hunk along the beam direction [mm]
+  double depth_;
+  /// description of the model to record with the run
+  std::string description_;
+  /// number of tracks we replaced
+  long unsigned int replaced_{0};
+  /// number of particles we created
+  long unsigned int created_{0};
+ public:
+  /**
+   * Load the trained table
+   *
+   * The table only describes the target it was trained in, so the
+   * run header of the training file must have the same target material
+   * and depth as the run using it.
+   *
+   * @throws std::runtime_error if the training target differs
+   * @param[in] filepath file written by dimuon-simulate --train-leakage
+   * @param[in] target target material as named in G4NistManager
+   * @param[in] depth depth of the hunk [mm]
+   */
+  LeakageModel(const std::string& filepath, const std::string& target, double depth);
+
+  /**
+   * Print out how many tracks were replaced
+   */
+  ~LeakageModel();
+
+  /// maximum kinetic energy of tracks we replace [MeV]
+  double max_energy() const {
+    return table_.max_energy();
+  }
+
+  /// the file and maximum energy of the model to record with the run
+  const std::string& description() const {
+    return description_;
+  }
+
+  /**
+   * Only electrons, positrons, and photons are replaced
+   *
+   * @param[in] particle definition of particle
+   */
+  G4bool IsApplicable(const G4ParticleDefinition& particle) final override;
+
+  /**
+   * Replace tracks below the maximum energy that we did not create
+   *
+   * @param[in] fast_track track in the hunk
+   */
+  G4bool ModelTrigger(const G4FastTrack& fast_track) final override;
+
+  /**
+   * Kill the track and create the particles leaving the hunk
+   *
+   * @param[in] fast_track track being replaced
+   * @param[in,out] fast_step step with the final state of the track and its secondaries
+   */
+  void DoIt(const G4FastTrack& fast_track, G4FastStep& fast_step) final override;
+};
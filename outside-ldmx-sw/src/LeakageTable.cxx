@@ -0,0 +1,192 @@
+#include "LeakageTable.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
+#include "G4Poisson.hh"
+#include "Randomize.hh"
+
+const std::array<std::string, LeakageTable::NumSpecies> LeakageTable::NAMES = {
+  "photon", "electron", "positron"
+};
+
+/// lowest kinetic energy of roots that are tabulated [MeV]
+static const double MIN_ENERGY = 0.1;
+/// number of logarithmic bins in the root energy
+static const int N_ENERGY_BINS = 30;
+/// number of bins in the depth left
+static const int N_DEPTH_BINS = 20;
+/// number of bins in the fraction of the root energy carried by a leaving particle
+static const int N_FRACTION_BINS = 50;
+/// number of bins in the cosine of the polar angle of a leaving particle
+static const int N_ANGLE_BINS = 40;
+
+/// evenly spaced bin edges
+static std::vector<double> linear_edges(int n, double low, double high) {
+  std::vector<double> edges;
+  for (int i{0}; i <= n; ++i) edges.push_back(low + (high-low)*i/n);
+  return edges;
+}
+
+LeakageTable::Species LeakageTable::species(int pdg) {
+  switch (pdg) {
+    case 22: return Photon;
+    case 11: return Electron;
+    case -11: return Positron;
+    default: return NumSpecies;
+  }
+}
+
+LeakageTable::LeakageTable(double max_energy, double depth) {
+  if (max_energy <= MIN_ENERGY) {
+    throw std::runtime_error("The maximum energy of the leakage table must be above "
+        +std::to_string(MIN_ENERGY)+" MeV.");
+  }
+  std::vector<double> energy_edges;
+  for (int i{0}; i <= N_ENERGY_BINS; ++i) {
+    energy_edges.push_back(MIN_ENERGY*std::pow(max_energy/MIN_ENERGY, static_cast<double>(i)/N_ENERGY_BINS));
+  }
+  auto depth_edges{linear_edges(N_DEPTH_BINS, 0., depth)};
+  auto fraction_edges{linear_edges(N_FRACTION_BINS, 0., 1.)};
+  auto angle_edges{linear_edges(N_ANGLE_BINS, -1., 1.)};
+  for (int r{0}; r < NumSpecies; ++r) {
+    roots_[r] = TH2D(("leakage_roots_"+NAMES[r]).c_str(),
+        ";Root Kinetic Energy [MeV];Depth Left [mm]",
+        N_ENERGY_BINS, energy_edges.data(), N_DEPTH_BINS, depth_edges.data());
+    roots_[r].SetDirectory(nullptr);
+    for (int l{0}; l < NumSpecies; ++l) {
+      fraction_[r][l] = TH3D(("leakage_fraction_"+NAMES[r]+"_"+NAMES[l]).c_str(),
+          ";Root Kinetic Energy [MeV];Depth Left [mm];Fraction of Root Kinetic Energy",
+          N_ENERGY_BINS, energy_edges.data(), N_DEPTH_BINS, depth_edges.data(),
+          N_FRACTION_BINS, fraction_edges.data());
+      fraction_[r][l].SetDirectory(nullptr);
+      angle_[r][l] = TH3D(("leakage_angle_"+NAMES[r]+"_"+NAMES[l]).c_str(),
+          ";Root Kinetic Energy [MeV];Depth Left [mm];cos#theta",
+          N_ENERGY_BINS, energy_edges.data(), N_DEPTH_BINS, depth_edges.data(),
+          N_ANGLE_BINS, angle_edges.data());
+      angle_[r][l].SetDirectory(nullptr);
+    }
+  }
+}
+
+LeakageTable::LeakageTable(const std::string& filepath) {
+  TFile f{filepath.c_str()};
+  if (not f.IsOpen()) {
+    throw std::runtime_error("Unable to open leakage model '"+filepath+"'.");
+  }
+  auto load = [&](const std::string& name, auto& destination) {
+    using Hist = std::remove_reference_t<decltype(destination)>;
+    std::unique_ptr<Hist> h{f.Get<Hist>(name.c_str())};
+    if (not h) {
+      throw std::runtime_error("Leakage model '"+filepath+"' does not have '"+name+"'.");
+    }
+    destination = *h;
+    destination.SetDirectory(nullptr);
+  };
+  for (int r{0}; r < NumSpecies; ++r) {
+    load("leakage_roots_"+NAMES[r], roots_[r]);
+    for (int l{0}; l < NumSpecies; ++l) {
+      load("leakage_fraction_"+NAMES[r]+"_"+NAMES[l], fraction_[r][l]);
+      load("leakage_angle_"+NAMES[r]+"_"+NAMES[l], angle_[r][l]);
+    }
+  }
+  build_cdfs();
+}
+
+double LeakageTable::max_energy() const {
+  return roots_[Photon].GetXaxis()->GetXmax();
+}
+
+void LeakageTable::fill_root(Species root, double energy, double depth_left) {
+  roots_[root].Fill(energy, depth_left);
+}
+
+void LeakageTable::fill_leak(Species root, double energy, double depth_left,
+    Species leak, double leak_energy, double cos_theta) {
+  fraction_[root][leak].Fill(energy, depth_left, leak_energy/energy);
+  angle_[root][leak].Fill(energy, depth_left, cos_theta);
+}
+
+/// cumulative distribution of the input bins, normalized to one
+static std::vector<double> cdf(const TH3D& h, int ix, int iy) {
+  std::vector<double> c;
+  double sum{0.};
+  for (int iz{1}; iz <= h.GetNbinsZ(); ++iz) {
+    sum += h.GetBinContent(ix, iy, iz);
+    c.push_back(sum);
+  }
+  if (sum > 0.) for (double& v : c) v /= sum;
+  return c;
+}
+
+void LeakageTable::build_cdfs() {
+  const int nx{roots_[Photon].GetNbinsX()}, ny{roots_[Photon].GetNbinsY()};
+  for (int r{0}; r < NumSpecies; ++r) {
+    for (int l{0}; l < NumSpecies; ++l) {
+      auto& cdfs{cdfs_[r][l]};
+      cdfs.resize(nx*ny);
+      for (int ix{1}; ix <= nx; ++ix) {
+        for (int iy{1}; iy <= ny; ++iy) {
+          Distributions& d{cdfs[(ix-1)*ny + (iy-1)]};
+          double n_roots{roots_[r].GetBinContent(ix, iy)};
+          double n_leaks{0.};
+          for (int iz{1}; iz <= fraction_[r][l].GetNbinsZ(); ++iz) {
+            n_leaks += fraction_[r][l].GetBinContent(ix, iy, iz);
+          }
+          d.mean_multiplicity = n_roots > 0. ? n_leaks/n_roots : 0.;
+          d.fraction_cdf = cdf(fraction_[r][l], ix, iy);
+          d.angle_cdf = cdf(angle_[r][l], ix, iy);
+        }
+      }
+    }
+  }
+}
+
+/// sample a value from a cumulative distribution over the bins of the input axis
+static double sample_axis(const std::vector<double>& cdf, const TAxis* axis) {
+  auto it{std::upper_bound(cdf.begin(), cdf.end(), G4UniformRand())};
+  int bin = std::min<int>(std::distance(cdf.begin(), it), cdf.size()-1)+1;
+  return axis->GetBinLowEdge(bin) + axis->GetBinWidth(bin)*G4UniformRand();
+}
+
+std::vector<LeakageTable::Leak> LeakageTable::sample(Species root, double energy, double depth_left) const {
+  std::vector<Leak> leaks;
+  const TAxis* energy_axis{roots_[root].GetXaxis()};
+  const TAxis* depth_axis{roots_[root].GetYaxis()};
+  // the lowest energies are absorbed where they are
+  if (energy < energy_axis->GetXmin()) return leaks;
+  int ix = std::clamp(energy_axis->FindFixBin(energy), 1, energy_axis->GetNbins());
+  int iy = std::clamp(depth_axis->FindFixBin(depth_left), 1, depth_axis->GetNbins());
+  double remaining{energy};
+  for (int l{0}; l < NumSpecies; ++l) {
+    const Distributions& d{cdfs_[root][l][(ix-1)*depth_axis->GetNbins() + (iy-1)]};
+    if (d.mean_multiplicity <= 0.) continue;
+    long n = G4Poisson(d.mean_multiplicity);
+    for (long i{0}; i < n; ++i) {
+      double leak_energy{energy*sample_axis(d.fraction_cdf, fraction_[root][l].GetZaxis())};
+      if (leak_energy > remaining) continue;
+      remaining -= leak_energy;
+      leaks.push_back(Leak{
+          static_cast<Species>(l),
+          leak_energy,
+          sample_axis(d.angle_cdf, angle_[root][l].GetZaxis())
+      });
+    }
+  }
+  return leaks;
+}
+
+std::vector<const TH1*> LeakageTable::histograms() const {
+  std::vector<const TH1*> hists;
+  for (int r{0}; r < NumSpecies; ++r) {
+    hists.push_back(&roots_[r]);
+    for (int l{0}; l < NumSpecies; ++l) {
+      hists.push_back(&fraction_[r][l]);
+      hists.push_back(&angle_[r][l]);
+    }
+  }
+  return hists;
+}
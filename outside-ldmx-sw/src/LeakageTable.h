@@ -0,0 +1,136 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include "TFile.h"
+#include "TH2D.h"
+#include "TH3D.h"
+
+/**
+ * tabulated leakage of the low-energy electromagnetic shower out of the hunk
+ *
+ * The table is binned in the kinetic energy of an electron, positron, or photon
+ * below the maximum energy and its distance to the downstream face of the hunk
+ * (the "depth left"). For each bin, we count how many of these particles (roots)
+ * were simulated and, for each species leaving the hunk from their showers,
+ * the fraction of the root's kinetic energy and the cosine of the polar angle
+ * of each leaving particle.
+ *
+ * The tables are filled with full simulation by LeakageTrainer and written as
+ * histograms so that the training runs can be merged with dimuon-merge. They
+ * are then sampled by LeakageModel to replace the full simulation of the roots.
+ * Only electrons, positrons, and photons leaving the hunk are tabulated.
+ */
+class LeakageTable {
+ public:
+  /// the species we tabulate, both as roots and as leaving particles
+  enum Species {
+    Photon = 0,
+    Electron,
+    Positron,
+    NumSpecies
+  };
+  /// names of the species used in the histogram names
+  static const std::array<std::string, NumSpecies> NAMES;
+  /// a particle leaving the hunk sampled from the table
+  struct Leak {
+    /// species of the leaving particle
+    Species species;
+    /// kinetic energy of the leaving particle [MeV]
+    double energy;
+    /// cosine of the polar angle of the leaving particle
+    double cos_theta;
+  };
+  /**
+   * get the species of a particle
+   *
+   * @param[in] pdg PDG ID of particle
+   * @return species of particle, NumSpecies if it is not tabulated
+   */
+  static Species species(int pdg);
+ private:
+  /// number of roots in each energy and depth left bin
+  std::array<TH2D, NumSpecies> roots_;
+  /// fraction of the root energy carried by each leaving particle
+  std::array<std::array<TH3D, NumSpecies>, NumSpecies> fraction_;
+  /// cosine of the polar angle of each leaving particle
+  std::array<std::array<TH3D, NumSpecies>, NumSpecies> angle_;
+  /// the distributions to sample in a single bin of root energy and depth left
+  struct Distributions {
+    /// mean number of leaving particles per root
+    double mean_multiplicity{0.};
+    /// cumulative distributions of the fraction and angle, normalized to one
+    std::vector<double> fraction_cdf, angle_cdf;
+  };
+  /**
+   * distributions for sampling
+   *
+   * Indexed by root species, leaving species, and then the bin of
+   * the energy and depth left (energy major).
+   */
+  std::array<std::array<std::vector<Distributions>, NumSpecies>, NumSpecies> cdfs_;
+  /// build the cumulative distributions from the histograms
+  void build_cdfs();
+ public:
+  /**
+   * Book empty tables for training
+   *
+   * @param[in] max_energy maximum kinetic energy of roots [MeV]
+   * @param[in] depth depth of the hunk [mm]
+   */
+  LeakageTable(double max_energy, double depth);
+
+  /**
+   * Load tables that were trained and prepare them for sampling
+   *
+   * @throws std::runtime_error if the file cannot be opened or is missing tables
+   * @param[in] filepath file written by dimuon-simulate --train-leakage
+   */
+  LeakageTable(const std::string& filepath);
+
+  /// maximum kinetic energy of roots that have been tabulated [MeV]
+  double max_energy() const;
+
+  /**
+   * Count a root
+   *
+   * @param[in] root species of root
+   * @param[in] energy kinetic energy of root [MeV]
+   * @param[in] depth_left distance of root to downstream face of hunk [mm]
+   */
+  void fill_root(Species root, double energy, double depth_left);
+
+  /**
+   * Count a particle leaving the hunk from the shower of a root
+   *
+   * @param[in] root species of root
+   * @param[in] energy kinetic energy of root [MeV]
+   * @param[in] depth_left distance of root to downstream face of hunk [mm]
+   * @param[in] leak species of leaving particle
+   * @param[in] leak_energy kinetic energy of leaving particle [MeV]
+   * @param[in] cos_theta cosine of polar angle of leaving particle
+   */
+  void fill_leak(Species root, double energy, double depth_left,
+      Species leak, double leak_energy, double cos_theta);
+
+  /**
+   * Sample the particles leaving the hunk from the shower of a root
+   *
+   * Roots below the tabulated energies are absorbed without any leakage
+   * and roots beyond the tabulated energies or depths are treated as the
+   * closest bin. The sampled particles are limited to the energy of the root.
+   *
+   * @param[in] root species of root
+   * @param[in] energy kinetic energy of root [MeV]
+   * @param[in] depth_left distance of root to downstream face of hunk [mm]
+   * @return particles leaving the hunk
+   */
+  std::vector<Leak> sample(Species root, double energy, double depth_left) const;
+
+  /**
+   * Get the histograms so they can be written to the output file
+   */
+  std::vector<const TH1*> histograms() const;
+};
@@ -0,0 +1,54 @@
+#include "LeakageTrainer.h"
+
+#include "G4VPhysicalVolume.hh"
+
+LeakageTrainer::LeakageTrainer(double max_energy, double depth)
+  : table_{max_energy, depth} {}
+
+void LeakageTrainer::BeginOfEventAction(const G4Event*) {
+  roots_.clear();
+  root_of_.clear();
+}
+
+void LeakageTrainer::ClassifyNewTrack(const G4Track* track) {
+  // suspended tracks are re-classified, but they already have their root
+  if (track->GetCurrentStepNumber() != 0) return;
+  auto parent{root_of_.find(track->GetParentID())};
+  if (parent == root_of_.end()) return;
+  /**
+   * the root may have created secondaries before it fell below the
+   * maximum energy, those are not part of the shower we replace;
+   * the ones from the step that took it below the maximum are created
+   * at the time the root starts, so they are excluded as well
+   */
+  if (track->GetGlobalTime() <= roots_[parent->second].time) return;
+  root_of_[track->GetTrackID()] = parent->second;
+}
+
+/// check if the input point is in the hunk
+static bool in_hunk(const G4StepPoint* point) {
+  const G4VPhysicalVolume* pv{point->GetPhysicalVolume()};
+  return pv != nullptr and pv->GetName() == "Hunk";
+}
+
+void LeakageTrainer::UserSteppingAction(const G4Step* step) {
+  const G4Track* track{step->GetTrack()};
+  const G4StepPoint* pre{step->GetPreStepPoint()};
+  auto root{root_of_.find(track->GetTrackID())};
+  if (root == root_of_.end()) {
+    LeakageTable::Species species{LeakageTable::species(track->GetDefinition()->GetPDGEncoding())};
+    if (species == LeakageTable::NumSpecies or not in_hunk(pre)
+        or pre->GetKineticEnergy() >= table_.max_energy()) return;
+    roots_.push_back(Root{species, pre->GetKineticEnergy(), -pre->GetPosition().z(), pre->GetGlobalTime()});
+    table_.fill_root(species, roots_.back().energy, roots_.back().depth_left);
+    root = root_of_.emplace(track->GetTrackID(), roots_.size()-1).first;
+  }
+
+  const G4StepPoint* post{step->GetPostStepPoint()};
+  if (not in_hunk(pre) or in_hunk(post) or post->GetPhysicalVolume() == nullptr) return;
+  LeakageTable::Species leak{LeakageTable::species(track->GetDefinition()->GetPDGEncoding())};
+  if (leak == LeakageTable::NumSpecies) return;
+  const Root& r{roots_[root->second]};
+  table_.fill_leak(r.species, r.energy, r.depth_left,
+      leak, post->GetKineticEnergy(), post->GetMomentumDirection().z());
+}
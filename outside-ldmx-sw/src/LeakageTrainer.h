@@ -0,0 +1,79 @@
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "G4Event.hh"
+#include "G4Step.hh"
+#include "G4Track.hh"
+
+#include "LeakageTable.h"
+
+/**
+ * fill a LeakageTable from the full simulation of the shower in the hunk
+ *
+ * The roots of the table are the electrons, positrons, and photons at the
+ * point where LeakageModel would replace them: the start of their first step
+ * in the hunk below the maximum energy. Each track created by a root after
+ * that point (and each track they create, and so on) belongs to that root's
+ * shower, so every particle leaving the hunk from the shower can be counted
+ * against the root it came from.
+ *
+ * The tables are unweighted, so training should be done with unbiased runs
+ * without roulette.
+ */
+class LeakageTrainer {
+  /// the table we are filling
+  LeakageTable table_;
+  /// a root we are following this event
+  struct Root {
+    /// species of the root
+    LeakageTable::Species species;
+    /// kinetic energy of the root [MeV]
+    double energy;
+    /// distance of the root to the downstream face of the hunk [mm]
+    double depth_left;
+    /// global time at which the root was replaced [ns]
+    double time;
+  };
+  /// the roots of this event
+  std::vector<Root> roots_;
+  /// the index into roots_ of the shower each track belongs to
+  std::unordered_map<int, std::size_t> root_of_;
+ public:
+  /**
+   * Book the table
+   *
+   * @param[in] max_energy maximum kinetic energy of roots [MeV]
+   * @param[in] depth depth of the hunk [mm]
+   */
+  LeakageTrainer(double max_energy, double depth);
+
+  /**
+   * Forget the roots of the last event
+   *
+   * @param[in] event unused
+   */
+  void BeginOfEventAction(const G4Event* event);
+
+  /**
+   * Attach new tracks to the shower of the root their parent belongs to
+   *
+   * @param[in] track new track being classified
+   */
+  void ClassifyNewTrack(const G4Track* track);
+
+  /**
+   * Find new roots and count the particles leaving the hunk
+   *
+   * @param[in] step current step being processed
+   */
+  void UserSteppingAction(const G4Step* step);
+
+  /**
+   * Get the histograms of the table so they can be written to the output file
+   */
+  std::vector<const TH1*> histograms() const {
+    return table_.histograms();
+  }
+};
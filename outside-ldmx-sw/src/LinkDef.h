@@ -4,4 +4,6 @@
 #pragma link C++ class RunHeader+;
 #pragma link C++ class Particle+;
 #pragma link C++ class std::vector<Particle>+;
+#pragma link C++ class ColumnReader-;
+#pragma link C++ class ColumnReader::Block-;
 #endif
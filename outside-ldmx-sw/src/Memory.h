@@ -0,0 +1,27 @@
+#pragma once
+
+#include <unistd.h>
+
+#include <fstream>
+
+/**
+ * Inspecting the memory used by this process
+ */
+namespace memory {
+
+/**
+ * current resident set size of this process [MB]
+ *
+ * This is read from /proc/self/statm which is cheap but not free,
+ * so avoid calling it on every step.
+ *
+ * @return resident set size, 0 if it could not be read
+ */
+inline double resident_set_size() {
+  std::ifstream statm{"/proc/self/statm"};
+  long pages{0}, resident{0};
+  if (not (statm >> pages >> resident)) return 0.;
+  return resident*static_cast<double>(sysconf(_SC_PAGESIZE))/(1024.*1024.);
+}
+
+}  // namespace memory
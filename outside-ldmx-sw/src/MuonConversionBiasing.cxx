@@ -15,7 +15,7 @@ G4VBiasingOperation* MuonConversionBiasing::ProposeOccurenceBiasingOperation(con
   // got here with a photon and the muon-conversion process
   double interaction_length = callingProcess->GetWrappedProcess()->GetCurrentInteractionLength();
   double unbiased_xsec = 1./interaction_length;
-  double biased_xsec = unbiased_xsec * factor_;
+  double biased_xsec = unbiased_xsec * (table_ ? (*table_)(track->GetKineticEnergy()) : factor_);
   operation_->SetBiasedCrossSection(biased_xsec);
   operation_->Sample();
   return operation_;
@@ -28,6 +28,8 @@ G4VBiasingOperation* MuonConversionBiasing::ProposeNonPhysicsBiasingOperation(co
 }
 MuonConversionBiasing::MuonConversionBiasing(double factor, double threshold)
   : G4VBiasingOperator("bias-muon-conv"), factor_{factor}, threshold_{threshold}, operation_{nullptr} {}
+MuonConversionBiasing::MuonConversionBiasing(const BiasTable& table, double threshold)
+  : G4VBiasingOperator("bias-muon-conv"), factor_{1.}, table_{table}, threshold_{threshold}, operation_{nullptr} {}
 MuonConversionBiasing::~MuonConversionBiasing() {
   if (operation_) delete operation_;
 }
@@ -1,11 +1,17 @@
 #pragma once
 
+#include <optional>
+
 #include "G4VBiasingOperator.hh"
 #include "G4BOptnChangeCrossSection.hh"
 
+#include "BiasTable.h"
+
 class MuonConversionBiasing : public G4VBiasingOperator {
   /// the configured factor we will use to bias the muon-conversion process
   double factor_;
+  /// the factor as a function of photon energy, replacing factor_ if set
+  std::optional<BiasTable> table_;
   /// energy threshold above which photons need to be to be biased
   double threshold_;
   /// the operation we can give to Geant4 when we want to bias
@@ -28,6 +34,13 @@ class MuonConversionBiasing : public G4VBiasingOperator {
    * Create this biasing operator with the input factor to increase the muon-conversion xsec by
    */
   MuonConversionBiasing(double factor, double threshold);
+  /**
+   * Create this biasing operator with a factor depending on the energy of the photon
+   *
+   * @param[in] table factor to increase the muon-conversion xsec by at each photon energy
+   * @param[in] threshold energy above which photons are biased [MeV]
+   */
+  MuonConversionBiasing(const BiasTable& table, double threshold);
   /**
    * Close up this operator and delete the operation if it exists
    */
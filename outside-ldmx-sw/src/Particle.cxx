@@ -29,4 +29,5 @@ void Particle::operator=(const G4Track* track) {
   this->y = position.y();
   this->z = position.z();
   this->t = track->GetGlobalTime();
+  this->weight = track->GetWeight();
 }
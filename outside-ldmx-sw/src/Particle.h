@@ -1,6 +1,7 @@
 #pragma once
 
 #include "TObject.h"
+#include "Math/Vector4D.h"
 
 #include "G4Track.hh"
 
@@ -14,7 +15,8 @@ class Particle {
   int parent_id;
   double px, py, pz, energy;
   double x, y, z, t;
-  ClassDef(Particle, 1);
+  double weight{1.};
+  ClassDef(Particle, 2);
  public:
   Particle() = default;
   /**
@@ -46,6 +48,40 @@ class Particle {
   int id() const {
     return track_id;
   }
+  /**
+   * Get the track ID of the parent of the particle
+   */
+  int parent() const {
+    return parent_id;
+  }
+  /**
+   * Get the PDG ID of the particle
+   */
+  int pdg() const {
+    return pdg_id;
+  }
+  /**
+   * Get the four-momentum of the particle [MeV]
+   */
+  ROOT::Math::PxPyPzEVector momentum() const {
+    return {px, py, pz, energy};
+  }
+  /**
+   * Get the four-position of the particle [mm, ns]
+   */
+  ROOT::Math::XYZTVector position() const {
+    return {x, y, z, t};
+  }
+
+  /**
+   * Get the weight of the track when it was recorded
+   *
+   * This is only different from one if the track (or one of its
+   * ancestors) was biased, split, or survived Russian roulette.
+   */
+  double track_weight() const {
+    return weight;
+  }
 
   /**
    * "Assign" a G4Track to this Particle.
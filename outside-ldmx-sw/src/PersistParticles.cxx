@@ -1,8 +1,17 @@
 #include "PersistParticles.h"
 
+#include "Kinematics.h"
 #include "RunHeader.h"
 
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+
 #include "G4EventManager.hh"
+#include "G4StackManager.hh"
+#include "G4Electron.hh"
+#include "G4Positron.hh"
 #include "G4RunManager.hh"
 #include "G4Gamma.hh"
 #include "G4VProcess.hh"
@@ -18,8 +27,8 @@ static void AbortEvent(const std::string& reason) {
 
 }
 
-PersistParticles::PersistParticles(const std::string& out_file, std::optional<double> filter_threshold, std::optional<double> bias_factor, const std::string& target, double depth, double beam, bool photons, long seed)
-  : out_{out_file.c_str(), "RECREATE"}, filter_threshold_{filter_threshold}, bias_factor_{bias_factor}, target_{target}, depth_{depth}, beam_{beam}, photons_{photons}, seed_{seed} {
+PersistParticles::PersistParticles(const std::string& out_file, std::optional<double> filter_threshold, std::optional<double> bias_factor, std::optional<double> brem_bias_factor, const std::string& target, double depth, double beam, bool photons, long seed)
+  : out_{out_file.c_str(), "RECREATE"}, filter_threshold_{filter_threshold}, bias_factor_{bias_factor}, brem_bias_factor_{brem_bias_factor}, target_{target}, depth_{depth}, beam_{beam}, photons_{photons}, seed_{seed} {
     out_.cd();
     events_ = new TTree("events","dimuon_events");
     events_->Branch("incident", &incident_);
@@ -29,6 +38,9 @@ PersistParticles::PersistParticles(const std::string& out_file, std::optional<do
     events_->Branch("extra", &extra_);
     events_->Branch("ecal", &ecal_);
     events_->Branch("weight", &weight_, "weight/D");
+    stage_bounds_ = {filter_threshold_.value_or(0.)};
+    cpu_start_ = std::clock();
+    aborted_at_stage_.resize(stage_bounds_.size(), 0);
 }
 
 PersistParticles::~PersistParticles() {
@@ -36,16 +48,39 @@ PersistParticles::~PersistParticles() {
     << "[ dimuon-simulate ]: Generated " << events_completed_
     << " events out of " << events_started_ << " requested."
     << std::endl;
+  if (events_truncated_ > 0) {
+    std::cout << "[ dimuon-simulate ]: Dropped " << events_truncated_
+      << " events cut short by resource limits." << std::endl;
+  }
+  if (stage_bounds_.size() > 1) {
+    std::cout << "[ dimuon-simulate ]: Events aborted after each stage";
+    for (std::size_t i{0}; i < stage_bounds_.size(); ++i) {
+      std::cout << ", " << stage_bounds_[i] << " MeV: " << aborted_at_stage_[i];
+    }
+    std::cout << std::endl;
+  }
+  if (not selection_.empty()) selection_.print(std::cout);
   RunHeader rh(
-      events_started_,
+      equivalent_tries_.value_or(events_started_)-events_truncated_,
       filter_threshold_,
       bias_factor_,
+      brem_bias_factor_,
       target_,
       depth_,
       beam_,
       photons_,
       seed_
   );
+  rh.set_weight_statistics(events_completed_, weight_sum_, weight_sq_sum_);
+  rh.set_truncated(events_truncated_);
+  rh.set_selection(selection_.description(), events_selected_);
+  rh.set_bias_function(bias_function_);
+  rh.set_fast_leakage(fast_leakage_);
+  rh.set_stopping_point(
+      stop_reason_.empty() ? "num-events" : stop_reason_,
+      target_precision_.value_or(0.),
+      precision()
+  );
   out_.WriteObject(&rh, "run");
   events_->Write();
   out_.Close();
@@ -67,7 +102,10 @@ bool PersistParticles::success() {
 
 void PersistParticles::BeginOfEventAction(const G4Event*) {
   no_more_particles_above_threshold_ = false;
+  stage_ = 0;
+  viable_waiting_ = 0;
   weight_ = 1.;
+  truncated_ = false;
   extra_.clear();
   incident_.clear();
   parent_.clear();
@@ -83,13 +121,14 @@ G4ClassificationOfNewTrack PersistParticles::ClassifyNewTrack(const G4Track* tra
    * threshold or if there are no more particles above the threshold,
    * we tell Geant4 to process it as soon as possible.
    */
-  if (track->GetDefinition()==G4MuonMinus::MuonMinus() or track->GetDefinition()==G4MuonPlus::MuonPlus() or track->GetKineticEnergy() > filter_threshold_.value_or(0.) or no_more_particles_above_threshold_) {
+  if (track->GetDefinition()==G4MuonMinus::MuonMinus() or track->GetDefinition()==G4MuonPlus::MuonPlus() or track->GetKineticEnergy() > stage_bounds_[stage_] or no_more_particles_above_threshold_) {
     return fUrgent;
   }
   /**
    * track is below the threshold and so we push it onto
    * the waiting stack
    */
+  if (is_viable(track)) ++viable_waiting_;
   return fWaiting;
 }
 
@@ -163,8 +202,8 @@ void PersistParticles::UserSteppingAction(const G4Step* step) {
    */
   auto pre_energy{step->GetPreStepPoint()->GetKineticEnergy()};
   auto post_energy{step->GetPostStepPoint()->GetKineticEnergy()};
-  if (pre_energy >= filter_threshold_.value_or(0.) and 
-      post_energy < filter_threshold_.value_or(0.)) {
+  if (pre_energy >= stage_bounds_[stage_] and 
+      post_energy < stage_bounds_[stage_]) {
     step->GetTrack()->SetTrackStatus(fSuspend);
   }
   /**
@@ -198,17 +237,167 @@ void PersistParticles::NewScoringPlaneHit(const G4String&, const G4Step* step) {
 void PersistParticles::PostUserTrackingAction(const G4Track* /*track*/) {
 }
 
+bool PersistParticles::is_viable(const G4Track* track) const {
+  const G4ParticleDefinition* def{track->GetDefinition()};
+  if (def != G4Gamma::Gamma() and def != G4Electron::Electron() and def != G4Positron::Positron()) {
+    return false;
+  }
+  // one muon must have a total energy above the threshold and the other must at least be produced
+  return track->GetKineticEnergy() > filter_threshold_.value_or(0.) + G4MuonMinus::MuonMinus()->GetPDGMass();
+}
+
 void PersistParticles::NewStage() {
+  if (stage_+1 < stage_bounds_.size() and not no_more_particles_above_threshold_) {
+    /**
+     * the muons are always urgent, so if the muon-conversion already
+     * happened we know if the event passes the filter
+     */
+    if (parent_.is_valid()) {
+      if (not success()) {
+        ++aborted_at_stage_[stage_];
+        AbortEvent("unsuccessful generation (both muons below threshold)");
+        return;
+      }
+      no_more_particles_above_threshold_ = true;
+    } else if (viable_waiting_ == 0) {
+      ++aborted_at_stage_[stage_];
+      AbortEvent("unsuccessful generation (no particles left that could produce a muon above threshold)");
+      return;
+    } else {
+      ++stage_;
+      viable_waiting_ = 0;
+    }
+    /**
+     * the waiting tracks are now on the urgent stack, sort them into the next stage
+     *
+     * The stacking action only passes these back to us, so the other
+     * classifiers (e.g. the weight window) still decide once per track.
+     */
+    G4EventManager::GetEventManager()->GetStackManager()->ReClassify();
+    return;
+  }
   no_more_particles_above_threshold_ = true;
   if (not success()) {
+    ++aborted_at_stage_[stage_];
     AbortEvent("unsuccessful generation (no muon-conv found or both muons below threshold)");
     return;
   }
 }
 
+void PersistParticles::SetStageTiers(std::vector<double> tiers) {
+  if (not filter_threshold_) {
+    throw std::runtime_error("Stages of the shower are only helpful when filtering.");
+  }
+  std::sort(tiers.begin(), tiers.end(), std::greater<double>());
+  if (not tiers.empty() and tiers.back() <= filter_threshold_.value()) {
+    throw std::runtime_error("The energy tiers must all be above the filter threshold.");
+  }
+  tiers.push_back(filter_threshold_.value());
+  stage_bounds_ = tiers;
+  aborted_at_stage_.assign(stage_bounds_.size(), 0);
+}
+
 void PersistParticles::EndOfEventAction(const G4Event*) {
-  if (success()) {
+  if (truncated_) {
+    ++events_truncated_;
+    check_stopping_criteria();
+    return;
+  }
+  bool kept{success()};
+  if (kept) {
     ++events_completed_;
-    events_->Fill();
+    weight_sum_ += weight_;
+    weight_sq_sum_ += weight_*weight_;
+    if (selection_.pass(mu_plus_, mu_minus_, extra_, ecal_)) {
+      ++events_selected_;
+      if (write_derived_) calculate_derived();
+      events_->Fill();
+    }
+  }
+  bool converted{kept and mu_plus_.is_valid() and mu_minus_.is_valid()};
+  yield_[0].add(converted ? weight_ : 0.);
+  if (precision_bins_.size() > 1) {
+    double leading{converted ? std::max(mu_plus_.total_energy(), mu_minus_.total_energy()) : 0.};
+    for (std::size_t i{0}; i+1 < precision_bins_.size(); ++i) {
+      bool in_bin{converted and leading >= precision_bins_[i] and leading < precision_bins_[i+1]};
+      yield_[i+1].add(in_bin ? weight_ : 0.);
+    }
   }
+  check_stopping_criteria();
+}
+
+double PersistParticles::precision() const {
+  double worst{0.};
+  for (const RunningStatistics& stats : yield_) worst = std::max(worst, stats.relative_uncertainty());
+  return worst;
+}
+
+/// minimum number of events with a yield in each bin before we trust its variance
+static const long unsigned int MIN_NONZERO_YIELDS = 10;
+
+void PersistParticles::check_stopping_criteria() {
+  if (not stop_reason_.empty()) return;
+  if (target_precision_) {
+    bool enough{std::all_of(yield_.begin(), yield_.end(), [](const RunningStatistics& stats) {
+          return stats.nonzero() >= MIN_NONZERO_YIELDS;
+        })};
+    if (enough and precision() < target_precision_.value()) {
+      stop_reason_ = "target-precision";
+    }
+  }
+  if (cpu_budget_ and static_cast<double>(std::clock()-cpu_start_)/CLOCKS_PER_SEC > cpu_budget_.value()) {
+    stop_reason_ = "cpu-budget";
+  }
+  if (not stop_reason_.empty()) {
+    std::cout << "[ dimuon-simulate ]: Stopping after " << events_started_
+      << " events due to " << stop_reason_ << " with a relative uncertainty on the yield of "
+      << precision() << std::endl;
+    G4RunManager::GetRunManager()->AbortRun(true);
+  }
+}
+
+void PersistParticles::SetStoppingCriteria(std::optional<double> target_precision, std::vector<double> bins, std::optional<double> cpu_budget) {
+  target_precision_ = target_precision;
+  cpu_budget_ = cpu_budget;
+  std::sort(bins.begin(), bins.end());
+  if (bins.size() == 1) {
+    throw std::runtime_error("At least two edges are needed to define bins of the yield.");
+  }
+  precision_bins_ = bins;
+  yield_.assign(std::max<std::size_t>(bins.size(), 1), RunningStatistics{});
+}
+
+const std::array<const char*, 8> PersistParticles::DERIVED_NAMES = {
+  "pair_mass", "opening_angle",
+  "mu_plus_theta", "mu_plus_phi", "mu_minus_theta", "mu_minus_phi",
+  "mu_plus_ecal_r", "mu_minus_ecal_r"
+};
+
+void PersistParticles::AddDerivedBranches() {
+  write_derived_ = true;
+  for (std::size_t i{0}; i < derived_.size(); ++i) {
+    events_->Branch(DERIVED_NAMES[i], &derived_[i], (std::string(DERIVED_NAMES[i])+"/F").c_str());
+  }
+}
+
+void PersistParticles::calculate_derived() {
+  derived_.fill(std::numeric_limits<float>::quiet_NaN());
+  if (not mu_plus_.is_valid() or not mu_minus_.is_valid()) return;
+  derived_[0] = kinematics::pair_mass(mu_plus_, mu_minus_);
+  derived_[1] = kinematics::opening_angle(mu_plus_, mu_minus_);
+  std::size_t i{2};
+  for (const Particle* mu : {&mu_plus_, &mu_minus_}) {
+    auto momentum{mu->momentum()};
+    derived_[i++] = momentum.Theta();
+    derived_[i++] = momentum.Phi();
+  }
+  for (const Particle* mu : {&mu_plus_, &mu_minus_}) {
+    const Particle* hit{kinematics::find_hit(ecal_, mu->id())};
+    if (hit != nullptr) derived_[i] = kinematics::radius(*hit);
+    ++i;
+  }
+}
+
+void PersistParticles::Write(const TObject& obj, const std::string& name) {
+  out_.WriteTObject(&obj, name.c_str());
 }
@@ -1,6 +1,9 @@
 #pragma once
 
+#include <array>
+#include <ctime>
 #include <optional>
+#include <vector>
 
 #include "G4MuonMinus.hh"
 #include "G4MuonPlus.hh"
@@ -12,6 +15,8 @@
 #include "TTree.h"
 
 #include "Particle.h"
+#include "RunningStatistics.h"
+#include "Selection.h"
 
 /**
  * user action used to store the sim particles *if* a muon-conversion occurred
@@ -50,14 +55,47 @@ class PersistParticles {
    * by Geant4.
    */
   double weight_{1.};
+  /// names of the derived kinematic branches in the order of derived_
+  static const std::array<const char*, 8> DERIVED_NAMES;
+  /**
+   * derived kinematics of the muons written as flat branches
+   *
+   * NaN if the event did not have a muon-conversion
+   * or the muon did not reach the ECal scoring plane.
+   */
+  std::array<float, 8> derived_;
+  /// whether the derived kinematic branches are written
+  bool write_derived_{false};
+  /// calculate the derived kinematics from the particles of this event
+  void calculate_derived();
   /// number of events that we simulated
   long unsigned int events_started_{0};
+  /// number of events cut short by a resource limit
+  long unsigned int events_truncated_{0};
+  /// the current event was cut short by a resource limit
+  bool truncated_{false};
   /// number of events with a dark brem in it
   long unsigned int events_completed_{0};
+  /// number of kept events passing the selection and written
+  long unsigned int events_selected_{0};
+  /// selection kept events must pass to be written
+  Selection selection_;
+  /// sum of the weights of the events we kept
+  double weight_sum_{0.};
+  /// sum of the squares of the weights of the events we kept
+  double weight_sq_sum_{0.};
+  /// number of events to record as tries if not the number we started
+  std::optional<long unsigned int> equivalent_tries_;
   /// minimum energy of a muon to have to keep the event
   std::optional<double> filter_threshold_;
   /// factor to bias muon-conversion by in material target'
   std::optional<double> bias_factor_;
+  /// description of the energy-dependent muon-conversion bias (empty if constant)
+  std::string bias_function_;
+  /// description of the fast leakage model (empty if fully simulated)
+  std::string fast_leakage_;
+  /// factor to bias brem of electrons by in material target
+  std::optional<double> brem_bias_factor_;
   /// target material (as named in G4NistManager)
   std::string target_;
   /// depth of target in mm
@@ -70,6 +108,43 @@ class PersistParticles {
   long seed_;
   /// flag keeping track of current stage of simulated event
   bool no_more_particles_above_threshold_;
+  /**
+   * lower kinetic energy bounds of each stage in descending order [MeV]
+   *
+   * The last stage is always bounded by the filter threshold.
+   */
+  std::vector<double> stage_bounds_;
+  /// index of the current stage of the simulated event
+  std::size_t stage_{0};
+  /// number of waiting tracks that could still produce a muon above the filter threshold
+  long unsigned int viable_waiting_{0};
+  /// number of events aborted at the end of each stage
+  std::vector<long unsigned int> aborted_at_stage_;
+  /**
+   * running statistics of the muon-conversion yield of each event
+   *
+   * The yield of an event is its weight if it was kept and had a
+   * muon-conversion and zero otherwise, so the mean is the yield per
+   * simulated event. The first entry is the total yield and any others
+   * are the yields within bins of the leading muon energy.
+   */
+  std::vector<RunningStatistics> yield_ = std::vector<RunningStatistics>(1);
+  /// edges of the bins of leading muon energy to track the yield in [MeV]
+  std::vector<double> precision_bins_;
+  /// relative uncertainty on the yield(s) to stop the run at
+  std::optional<double> target_precision_;
+  /// CPU time to stop the run after [s]
+  std::optional<double> cpu_budget_;
+  /// CPU time when we started
+  std::clock_t cpu_start_;
+  /// why the run stopped, empty if it hasn't stopped early
+  std::string stop_reason_;
+  /// the largest relative uncertainty of the yields we are tracking
+  double precision() const;
+  /// check if the run should stop, ending it if so
+  void check_stopping_criteria();
+  /// check if a track could still produce a muon above the filter threshold
+  bool is_viable(const G4Track* track) const;
  public:
   /**
    * Open the output file and set whether we filter or not
@@ -77,7 +152,7 @@ class PersistParticles {
    * In addition to opening the output file, we create the event tree
    * and set up the branches we will write our member variables to.
    */
-  PersistParticles(const std::string& out_file, std::optional<double> filter_threshold, std::optional<double> bias_factor, const std::string& target, double depth, double beam, bool photons, long seed);
+  PersistParticles(const std::string& out_file, std::optional<double> filter_threshold, std::optional<double> bias_factor, std::optional<double> brem_bias_factor, const std::string& target, double depth, double beam, bool photons, long seed);
 
   /**
    * Print out the number of events with a dark brem compared to the requested number
@@ -122,6 +197,9 @@ class PersistParticles {
    * gives us an opportunity in NewStage to check if the event
    * has been successful before the entire shower has been
    * simulated.
+   *
+   * With more than one stage, tracks are only urgent if they are
+   * above the lower bound of the current stage.
    */
   G4ClassificationOfNewTrack ClassifyNewTrack(const G4Track* track);
 
@@ -167,13 +245,165 @@ class PersistParticles {
    * have been processed and therefore if we have not successfully
    * produced a muon-conversion yet, we do not have enough energy
    * to do so and so we should abort the event.
+   *
+   * With more than one stage, at the end of the intermediate stages
+   * we abort if a muon-conversion happened but failed the filter or
+   * if no waiting photon or electron has enough energy to produce a
+   * muon above the threshold. Otherwise, we move to the next stage
+   * and re-classify the waiting tracks into it.
    */
   void NewStage();
 
   /**
    * Check and write if successful
    *
+   * The weight of a successful event is included in the running
+   * weight sums that are stored in the run header. It is then only
+   * written if it passes the selection, so the EoT is calculated
+   * from all successful events.
+   *
+   * Events cut short by a resource limit are skipped entirely
+   * since their showers are incomplete.
+   *
    * @see success for how successful is defined
    */
   void EndOfEventAction(const G4Event* event);
+
+  /**
+   * Mark the current event as cut short by a resource limit
+   *
+   * It is not written, not included in the weight sums, and not
+   * counted as a try, so the EoT and the leakage are not biased by
+   * its incomplete shower. The number of these events is recorded
+   * in the run header.
+   */
+  void TruncateEvent() {
+    truncated_ = true;
+  }
+
+  /**
+   * Write an additional object into the output file
+   *
+   * This is helpful for other scorers that want their results to
+   * live alongside the events and run header.
+   *
+   * @param[in] obj object to write
+   * @param[in] name name to write the object under
+   */
+  void Write(const TObject& obj, const std::string& name);
+
+  /**
+   * Write derived kinematics of the muons as additional flat branches
+   *
+   * The pair mass, opening angle, polar and azimuthal angles of each muon,
+   * and the radius of each muon at the ECal scoring plane are calculated
+   * for each kept event so that readers do not need to rebuild them
+   * from the four-vectors.
+   *
+   * @see kinematics for how they are calculated
+   */
+  void AddDerivedBranches();
+
+  /**
+   * Only write successful events that pass the input selection
+   *
+   * Events that fail are counted by the selection and the
+   * selection is recorded in the run header.
+   *
+   * @param[in] selection selection events must pass
+   */
+  void SetSelection(const Selection& selection) {
+    selection_ = selection;
+  }
+
+  /**
+   * Record the energy-dependent muon-conversion bias in the run header
+   *
+   * @param[in] function description of the bias function
+   */
+  void SetBiasFunction(const std::string& function) {
+    bias_function_ = function;
+  }
+
+  /**
+   * Record the fast leakage model in the run header
+   *
+   * @param[in] model description of the model
+   */
+  void SetFastLeakage(const std::string& model) {
+    fast_leakage_ = model;
+  }
+
+  /**
+   * Set the number of beam particles these events represent
+   *
+   * This is necessary when the primaries do not come directly from
+   * the beam, for example when replaying a phase space file, so that
+   * the number of tries stored in the run header is still the
+   * number of beam particles simulated.
+   *
+   * @param[in] tries number of beam particles simulated
+   */
+  void SetEquivalentTries(long unsigned int tries) {
+    equivalent_tries_ = tries;
+  }
+
+  /**
+   * Split the part of the shower above the filter threshold into stages
+   *
+   * The tracks are processed in order of these energy tiers so that the
+   * decision to abort an event can be made as soon as no muon-conversion
+   * passing the filter is possible.
+   *
+   * @throws std::runtime_error if not filtering or a tier is not above the filter threshold
+   * @param[in] tiers lower kinetic energy bounds of the stages above the filter threshold [MeV]
+   */
+  void SetStageTiers(std::vector<double> tiers);
+
+  /**
+   * Stop the run once the yield is known well enough or the CPU time runs out
+   *
+   * The run still stops at the requested number of events if neither
+   * criterion is met before then.
+   *
+   * @param[in] target_precision relative uncertainty on the yield(s) to stop at
+   * @param[in] bins edges of the bins of leading muon energy [MeV] in which
+   *   the yield must reach the target precision as well (empty for only the total)
+   * @param[in] cpu_budget CPU time in seconds to stop after
+   */
+  void SetStoppingCriteria(std::optional<double> target_precision, std::vector<double> bins, std::optional<double> cpu_budget);
+
+  /**
+   * Record why the run stopped if it was ended from elsewhere
+   *
+   * @param[in] reason why the run stopped
+   */
+  void SetStopReason(const std::string& reason) {
+    stop_reason_ = reason;
+  }
+
+  /// number of events started so far
+  long unsigned int events_started() const {
+    return events_started_;
+  }
+
+  /// number of events kept so far
+  long unsigned int events_completed() const {
+    return events_completed_;
+  }
+
+  /// sum of the weights of the events kept so far
+  double weight_sum() const {
+    return weight_sum_;
+  }
+
+  /// number of particles recorded leaving the target in this event
+  std::size_t num_extra() const {
+    return extra_.size();
+  }
+
+  /// number of particles recorded entering the ECal in this event
+  std::size_t num_ecal() const {
+    return ecal_.size();
+  }
 };  // PersistDarkBremProducts
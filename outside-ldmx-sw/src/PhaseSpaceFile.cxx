@@ -0,0 +1,100 @@
+#include "PhaseSpaceFile.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace phase_space {
+
+/// identifier at the start of every phase space file
+static const char MAGIC[8] = {'D','I','M','U','O','N','P','S'};
+/// current version of the file format
+static const std::uint32_t VERSION = 1;
+/// number of records to hold before writing them to the file
+static const std::size_t WRITE_BLOCK_SIZE = 1<<16;
+
+Writer::Writer(const std::string& filepath)
+  : file_{filepath, std::ios::binary | std::ios::trunc}, header_{} {
+  if (not file_.is_open()) {
+    throw std::runtime_error("Unable to open phase space file '"+filepath+"' for writing.");
+  }
+  std::copy(MAGIC, MAGIC+sizeof(MAGIC), header_.magic);
+  header_.version = VERSION;
+  file_.write(reinterpret_cast<const char*>(&header_), sizeof(Header));
+  buffer_.reserve(WRITE_BLOCK_SIZE);
+}
+
+Writer::~Writer() {
+  flush();
+  file_.seekp(0);
+  file_.write(reinterpret_cast<const char*>(&header_), sizeof(Header));
+  file_.close();
+}
+
+void Writer::write(std::uint32_t event, const G4Track* track) {
+  if (static_cast<std::int64_t>(event) != last_event_) {
+    ++header_.events;
+    last_event_ = event;
+  }
+  const G4ThreeVector& position{track->GetPosition()};
+  G4ThreeVector momentum{track->GetMomentum()};
+  buffer_.push_back(Record{
+      event,
+      static_cast<float>(position.x()),
+      static_cast<float>(position.y()),
+      static_cast<float>(position.z()),
+      static_cast<float>(momentum.x()),
+      static_cast<float>(momentum.y()),
+      static_cast<float>(momentum.z()),
+      static_cast<float>(track->GetWeight())
+  });
+  if (buffer_.size() >= WRITE_BLOCK_SIZE) flush();
+}
+
+void Writer::flush() {
+  file_.write(reinterpret_cast<const char*>(buffer_.data()), buffer_.size()*sizeof(Record));
+  buffer_.clear();
+}
+
+Reader::Reader(const std::string& filepath, std::size_t block_size)
+  : file_{filepath, std::ios::binary}, block_size_{block_size} {
+  if (not file_.is_open()) {
+    throw std::runtime_error("Unable to open phase space file '"+filepath+"' for reading.");
+  }
+  file_.read(reinterpret_cast<char*>(&header_), sizeof(Header));
+  if (not file_ or not std::equal(MAGIC, MAGIC+sizeof(MAGIC), header_.magic)) {
+    throw std::runtime_error("'"+filepath+"' is not a phase space file.");
+  }
+  if (header_.version != VERSION) {
+    throw std::runtime_error("'"+filepath+"' is phase space format version "
+        +std::to_string(header_.version)+" but we can only read version "
+        +std::to_string(VERSION)+".");
+  }
+  read_ahead();
+}
+
+Reader::~Reader() {
+  if (next_.valid()) next_.wait();
+}
+
+void Reader::read_ahead() {
+  next_ = std::async(std::launch::async, [this]() {
+    std::vector<Record> block(block_size_);
+    file_.read(reinterpret_cast<char*>(block.data()), block.size()*sizeof(Record));
+    block.resize(file_.gcount()/sizeof(Record));
+    return block;
+  });
+}
+
+const Record* Reader::peek() {
+  if (i_current_ >= current_.size()) {
+    // no read-ahead pending means we already hit the end of the file
+    if (not next_.valid()) return nullptr;
+    current_ = next_.get();
+    i_current_ = 0;
+    if (current_.empty()) return nullptr;
+    read_ahead();
+  }
+  return &current_[i_current_];
+}
+
+}  // namespace phase_space
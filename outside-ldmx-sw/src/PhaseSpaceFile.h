@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <string>
+#include <vector>
+
+#include "G4Track.hh"
+
+/**
+ * Compact binary file of photons for staging simulations
+ *
+ * The file starts with a fixed-size header followed by a stream of
+ * fixed-size records in the order the photons were produced.
+ * Photons from the same event are contiguous in the file and share the
+ * index of the event that produced them.
+ *
+ * All values are stored in Geant4's internal units (mm and MeV).
+ */
+namespace phase_space {
+
+/// the header at the start of every phase space file
+struct Header {
+  /// identifier of the file format
+  char magic[8];
+  /// version of the file format
+  std::uint32_t version;
+  /// unused, keeps the header eight-byte aligned
+  std::uint32_t reserved;
+  /// number of events that produced at least one photon
+  std::uint64_t events;
+  /// number of events simulated to produce the photons
+  std::uint64_t tries;
+};
+
+/// a single photon in the phase space file
+struct Record {
+  /// index of the event that produced this photon
+  std::uint32_t event;
+  /// position of the photon [mm]
+  float x, y, z;
+  /// momentum of the photon [MeV]
+  float px, py, pz;
+  /// weight of the photon when it was produced
+  float weight;
+};
+
+static_assert(sizeof(Header) == 32, "phase space header is not packed");
+static_assert(sizeof(Record) == 32, "phase space record is not packed");
+
+/**
+ * Write photons into a phase space file
+ *
+ * Records are held in a buffer and written in blocks.
+ * The header is written as a placeholder when opening and
+ * then overwritten with the final counts when closing.
+ */
+class Writer {
+  /// output file stream
+  std::ofstream file_;
+  /// records waiting to be written
+  std::vector<Record> buffer_;
+  /// header to write when closing
+  Header header_;
+  /// index of last event a record was written for
+  std::int64_t last_event_{-1};
+ public:
+  /// open the file and write the placeholder header
+  Writer(const std::string& filepath);
+  /// close the file, writing the final header
+  ~Writer();
+  /// write a photon from the input event
+  void write(std::uint32_t event, const G4Track* track);
+  /// set the number of events that were simulated
+  void set_tries(std::uint64_t tries) {
+    header_.tries = tries;
+  }
+  /// write the buffer to the file
+  void flush();
+};
+
+/**
+ * Read photons from a phase space file
+ *
+ * Blocks of records are read in a background task while the records
+ * of the previous block are being consumed, so simulating the photons
+ * does not wait on the disk.
+ */
+class Reader {
+  /// input file stream, only touched by the read-ahead task
+  std::ifstream file_;
+  /// header read when opening
+  Header header_;
+  /// block of records currently being consumed
+  std::vector<Record> current_;
+  /// index of next record to consume in the current block
+  std::size_t i_current_{0};
+  /// read-ahead of the next block
+  std::future<std::vector<Record>> next_;
+  /// number of records in each block
+  std::size_t block_size_;
+  /// start reading the next block in the background
+  void read_ahead();
+ public:
+  /// open the file and start reading the first block
+  Reader(const std::string& filepath, std::size_t block_size = 1<<16);
+  /// wait for any outstanding read before closing
+  ~Reader();
+  /// the header of the file
+  const Header& header() const {
+    return header_;
+  }
+  /// look at the next record without consuming it, nullptr if there are no more
+  const Record* peek();
+  /// consume the next record
+  void pop() {
+    ++i_current_;
+  }
+};
+
+}  // namespace phase_space
@@ -0,0 +1,38 @@
+#include "PhaseSpaceRecorder.h"
+
+#include <limits>
+#include <stdexcept>
+
+#include "G4Gamma.hh"
+
+PhaseSpaceRecorder::PhaseSpaceRecorder(const std::string& filepath, double min_energy, double depth)
+  : writer_{filepath}, min_energy_{min_energy}, depth_{depth} {}
+
+PhaseSpaceRecorder::~PhaseSpaceRecorder() {
+  writer_.set_tries(tries_);
+}
+
+void PhaseSpaceRecorder::BeginOfEventAction(const G4Event*) {
+  /**
+   * the records store the event index in 32 bits, so refuse to silently
+   * truncate it rather than mix photons of different events on replay
+   */
+  if (tries_ > std::numeric_limits<std::uint32_t>::max()) {
+    throw std::runtime_error("More events than can be indexed in a phase space file, split the run into shards.");
+  }
+  event_ = static_cast<std::uint32_t>(tries_);
+  ++tries_;
+}
+
+bool PhaseSpaceRecorder::ClassifyNewTrack(const G4Track* track) {
+  // tracks that have already been stepped are being re-classified after suspension
+  if (track->GetCurrentStepNumber() > 0) return false;
+  if (track->GetDefinition() != G4Gamma::Gamma()) return false;
+  // only secondaries, --phase-space-out cannot be used with a photon beam
+  if (track->GetCreatorProcess() == nullptr) return false;
+  if (track->GetKineticEnergy() < min_energy_) return false;
+  double z{track->GetPosition().z()};
+  if (z < -depth_ or z > 0.) return false;
+  writer_.write(event_, track);
+  return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "G4Track.hh"
+#include "G4Event.hh"
+
+#include "PhaseSpaceFile.h"
+
+/**
+ * stage-1 of a staged simulation: record high-energy photons
+ *
+ * Photons produced within the hunk above a minimum energy are written
+ * to a phase space file and then killed so that their showers (and any
+ * muon-conversions) are left to be simulated when the file is replayed
+ * with a PhaseSpaceSource.
+ *
+ * Since only photons above the minimum energy are recorded, the same
+ * filtering threshold can be used to abort events in this stage
+ * once no more particles are above it.
+ */
+class PhaseSpaceRecorder {
+  /// the file we are writing to
+  phase_space::Writer writer_;
+  /// minimum kinetic energy of a photon to be recorded [MeV]
+  double min_energy_;
+  /// depth of hunk along beam direction [mm]
+  double depth_;
+  /// number of events started
+  std::uint64_t tries_{0};
+  /// index of the current event
+  std::uint32_t event_{0};
+ public:
+  /**
+   * Open the phase space file for writing
+   *
+   * @param[in] filepath path to phase space file
+   * @param[in] min_energy minimum kinetic energy of photons to record in MeV
+   * @param[in] depth thickness of the hunk in mm
+   */
+  PhaseSpaceRecorder(const std::string& filepath, double min_energy, double depth);
+
+  /**
+   * Write the number of events started to the file before closing it
+   */
+  ~PhaseSpaceRecorder();
+
+  /**
+   * Count the event and keep its index for the records
+   *
+   * @param[in] event unused
+   */
+  void BeginOfEventAction(const G4Event* event);
+
+  /**
+   * Record a new track if it is a secondary photon within the hunk
+   * above the minimum energy.
+   *
+   * @param[in] track new track to check
+   * @return true if the track was recorded and should be killed
+   */
+  bool ClassifyNewTrack(const G4Track* track);
+};
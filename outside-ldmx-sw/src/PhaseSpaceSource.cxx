@@ -0,0 +1,41 @@
+#include "PhaseSpaceSource.h"
+
+#include "G4Event.hh"
+#include "G4Gamma.hh"
+#include "G4PrimaryParticle.hh"
+#include "G4PrimaryVertex.hh"
+
+PhaseSpaceSource::PhaseSpaceSource(const std::string& filepath)
+  : G4VUserPrimaryGeneratorAction(), reader_{filepath} {}
+
+void PhaseSpaceSource::GeneratePrimaries(G4Event* event) {
+  const phase_space::Record* record{reader_.peek()};
+  if (record == nullptr) {
+    throw std::runtime_error("Requested more events than are available in the phase space file.");
+  }
+  last_event_ = record->event;
+  ++generated_;
+  while (record != nullptr and static_cast<std::int64_t>(record->event) == last_event_) {
+    /**
+     * the event weight only accumulates the biasing done within this run,
+     * so a weighted photon would have its stage 1 weight silently dropped
+     */
+    if (record->weight != 1.f) {
+      throw std::runtime_error("Photon in event "+std::to_string(record->event)
+          +" of the phase space file has a weight of "+std::to_string(record->weight)
+          +" but only unweighted stage 1 samples can be replayed.");
+    }
+    auto vertex = new G4PrimaryVertex(record->x, record->y, record->z, 0.);
+    auto photon = new G4PrimaryParticle(G4Gamma::Gamma(), record->px, record->py, record->pz);
+    photon->SetWeight(record->weight);
+    vertex->SetPrimary(photon);
+    event->AddPrimaryVertex(vertex);
+    reader_.pop();
+    record = reader_.peek();
+  }
+}
+
+std::uint64_t PhaseSpaceSource::tries() const {
+  if (generated_ >= reader_.header().events) return reader_.header().tries;
+  return last_event_ + 1;
+}
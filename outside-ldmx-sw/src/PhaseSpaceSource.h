@@ -0,0 +1,51 @@
+#pragma once
+
+#include "G4VUserPrimaryGeneratorAction.hh"
+
+#include "PhaseSpaceFile.h"
+
+/**
+ * the primary generator for stage-2 of a staged simulation
+ *
+ * Each event is made from the photons recorded from a single event
+ * by the PhaseSpaceRecorder, each photon as its own primary vertex
+ * at the position it was produced with the weight it was produced with.
+ * The file is read in blocks ahead of when they are needed.
+ */
+class PhaseSpaceSource : public G4VUserPrimaryGeneratorAction {
+  /// the file we are reading from
+  phase_space::Reader reader_;
+  /// index of the stage-1 event of the last photon we generated
+  std::int64_t last_event_{-1};
+  /// number of events we have generated
+  std::uint64_t generated_{0};
+ public:
+  /**
+   * Open the phase space file for reading
+   */
+  PhaseSpaceSource(const std::string& filepath);
+
+  /**
+   * Start an event by providing all of the photons from one stage-1 event
+   *
+   * @throws std::runtime_error if there are no more events or a photon is weighted
+   */
+  void GeneratePrimaries(G4Event* event) final override;
+
+  /**
+   * Number of events available in the phase space file
+   */
+  std::uint64_t events() const {
+    return reader_.header().events;
+  }
+
+  /**
+   * Number of stage-1 events represented by the events generated so far
+   *
+   * Stage-1 events without any recorded photons are not in the file,
+   * so this is the total number of stage-1 events if we have generated
+   * all of the events in the file and otherwise the number of stage-1
+   * events up to and including the last one we generated.
+   */
+  std::uint64_t tries() const;
+};
@@ -0,0 +1,94 @@
+#include "PhotonFluence.h"
+
+#include <stdexcept>
+
+#include "G4Gamma.hh"
+#include "G4GammaConversionToMuons.hh"
+#include "G4NistManager.hh"
+
+PhotonFluence::PhotonFluence(double depth, const std::string& material, double max_energy,
+    int n_energy_bins, int n_depth_bins)
+  : depth_{depth},
+    spectrum_{"photon_fluence",
+      "Photon Track Length;Photon Energy [MeV];Depth in Hunk [mm];Weighted Track Length [mm]",
+      n_energy_bins, 0., max_energy,
+      n_depth_bins, 0., depth},
+    inverse_mfp_(n_energy_bins+2, 0.),
+    event_(n_depth_bins+2, 0.),
+    yield_{"photon_yield",
+      "Muon-Conversion Yield;Depth in Hunk [mm];Sum of Event Yields",
+      n_depth_bins, 0., depth},
+    total_{"photon_yield_total",
+      "Muon-Conversion Yield;;Sum of Event Yields",
+      1, 0., depth} {
+  // we own the histograms, not whatever ROOT directory happens to be open
+  spectrum_.SetDirectory(nullptr);
+  spectrum_.Sumw2();
+  yield_.SetDirectory(nullptr);
+  yield_.Sumw2();
+  total_.SetDirectory(nullptr);
+  total_.Sumw2();
+
+  G4Material* target = G4NistManager::Instance()->FindOrBuildMaterial(material);
+  if (not target) {
+    throw std::runtime_error("Material '"+material+"' unknown to G4NistManager.");
+  }
+  /**
+   * Below the muon-conversion threshold the mean free path is DBL_MAX
+   * so these bins do not contribute.
+   */
+  G4GammaConversionToMuons process;
+  const TAxis* energy_axis{spectrum_.GetXaxis()};
+  for (int i_energy{1}; i_energy <= energy_axis->GetNbins(); ++i_energy) {
+    inverse_mfp_[i_energy] = 1./process.ComputeMeanFreePath(energy_axis->GetBinCenter(i_energy), target);
+  }
+}
+
+void PhotonFluence::UserSteppingAction(const G4Step* step) {
+  if (step->GetTrack()->GetParticleDefinition() != G4Gamma::Gamma()) return;
+  const G4StepPoint* pre{step->GetPreStepPoint()};
+  const G4VPhysicalVolume* volume{pre->GetPhysicalVolume()};
+  if (volume == nullptr or volume->GetName() != "Hunk") return;
+  double length{step->GetStepLength()};
+  if (length <= 0.) return;
+
+  double energy{pre->GetKineticEnergy()};
+  double inverse_mfp{inverse_mfp_[spectrum_.GetXaxis()->FindFixBin(energy)]};
+  double weighted_length{pre->GetWeight()*length};
+  double start{pre->GetPosition().z() + depth_},
+         end{step->GetPostStepPoint()->GetPosition().z() + depth_};
+  if (start > end) std::swap(start, end);
+
+  /**
+   * steps (nearly) transverse to the beam axis stay within
+   * a single depth bin
+   */
+  const TAxis* depth_axis{spectrum_.GetYaxis()};
+  int first{std::max(1, depth_axis->FindFixBin(start))},
+      last{std::min(depth_axis->GetNbins(), depth_axis->FindFixBin(end))};
+  if (first == last) {
+    spectrum_.Fill(energy, depth_axis->GetBinCenter(first), weighted_length);
+    event_[first] += weighted_length*inverse_mfp;
+    return;
+  }
+
+  for (int bin{first}; bin <= last; ++bin) {
+    double low{std::max(start, depth_axis->GetBinLowEdge(bin))},
+           high{std::min(end, depth_axis->GetBinUpEdge(bin))};
+    if (high <= low) continue;
+    spectrum_.Fill(energy, depth_axis->GetBinCenter(bin), weighted_length*(high-low)/(end-start));
+    event_[bin] += weighted_length*(high-low)/(end-start)*inverse_mfp;
+  }
+}
+
+void PhotonFluence::EndOfEventAction(bool keep) {
+  double total{0.};
+  for (int bin{1}; bin <= yield_.GetNbinsX(); ++bin) {
+    if (not keep) event_[bin] = 0.;
+    if (event_[bin] == 0.) continue;
+    yield_.Fill(yield_.GetBinCenter(bin), event_[bin]);
+    total += event_[bin];
+    event_[bin] = 0.;
+  }
+  if (total > 0.) total_.Fill(total_.GetBinCenter(1), total);
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "G4Step.hh"
+
+#include "TH1D.h"
+#include "TH2D.h"
+
+/**
+ * track-length estimator of the photon fluence within the hunk
+ *
+ * Every step a photon takes within the Hunk contributes its length
+ * (multiplied by the track weight) to the bin of its energy and depth.
+ * Summing track length over a volume and dividing by that volume gives
+ * the fluence, so folding this spectrum with the inverse of the
+ * muon-conversion mean free path gives the number of muon-conversions
+ * expected directly without needing to wait for them to happen.
+ *
+ * The depth axis is measured from the upstream face of the hunk,
+ * so it spans from 0 to the depth of the hunk.
+ *
+ * The steps within a shower are correlated, so the uncertainty on the yield
+ * can not be taken from the bins of the spectrum. Instead, we also fold each
+ * event's track length with the inverse mean free path at the center of its
+ * energy bin as we go and fill the yield of each event once it is over.
+ * The sum of weights squared of these histograms is then the sum of the
+ * squared yields of the events, as needed for the variance of their mean.
+ */
+class PhotonFluence {
+  /// depth of hunk along beam direction [mm]
+  double depth_;
+  /// weighted track length [mm] binned in photon energy [MeV] and depth [mm]
+  TH2D spectrum_;
+  /// muon-conversion inverse mean free path [1/mm] at the center of each energy bin
+  std::vector<double> inverse_mfp_;
+  /// yield of the current event in each depth bin
+  std::vector<double> event_;
+  /// yield of each event in each depth bin
+  TH1D yield_;
+  /// total yield of each event
+  TH1D total_;
+ public:
+  /**
+   * Create the binning for the spectrum
+   *
+   * @throws std::runtime_error if the material is unknown to G4NistManager
+   * @param[in] depth thickness of the hunk in mm
+   * @param[in] material target material as named in G4NistManager
+   * @param[in] max_energy maximum photon energy to bin in MeV
+   * @param[in] n_energy_bins number of bins in photon energy
+   * @param[in] n_depth_bins number of bins in depth within hunk
+   */
+  PhotonFluence(double depth, const std::string& material, double max_energy, int n_energy_bins, int n_depth_bins);
+
+  /**
+   * Score the track length of a photon step within the hunk
+   *
+   * Photons do not lose energy continuously so the pre-step kinetic energy
+   * is the energy along the entire step. A step crossing a boundary between
+   * depth bins is split between them in proportion to the distance along
+   * the beam axis it spent within each.
+   *
+   * @param[in] step current step being processed
+   */
+  void UserSteppingAction(const G4Step* step);
+
+  /**
+   * Fill the yield of the event that just ended
+   *
+   * The spectrum has already been filled step by step, but the yield
+   * of an event cut short by a resource limit is dropped along with it.
+   *
+   * @param[in] keep false if the event was dropped
+   */
+  void EndOfEventAction(bool keep);
+
+  /**
+   * Get the spectrum so it can be written to the output file
+   */
+  const TH2D& spectrum() const {
+    return spectrum_;
+  }
+
+  /**
+   * Get the yield of the events in each depth bin so it can be written to the output file
+   */
+  const TH1D& yield() const {
+    return yield_;
+  }
+
+  /**
+   * Get the total yield of the events so it can be written to the output file
+   */
+  const TH1D& total() const {
+    return total_;
+  }
+};
@@ -1,13 +1,18 @@
 #include "RunHeader.h"
 
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
 #include "Version.h"
 
 ClassImp(RunHeader);
 
 RunHeader::RunHeader(
-    int tries,
+    Long64_t tries,
     std::optional<double> filter_threshold,
     std::optional<double> bias_factor,
+    std::optional<double> brem_bias_factor,
     const std::string& target,
     double depth,
     double beam,
@@ -25,5 +30,89 @@ RunHeader::RunHeader(
     seed_{seed},
     version_major_{version::MAJOR},
     version_minor_{version::MINOR},
-    version_patch_{version::PATCH}
+    version_patch_{version::PATCH},
+    brem_bias_factor_{brem_bias_factor.value_or(1.)}
 {}
+
+void RunHeader::set_weight_statistics(Long64_t accepted, double weight_sum, double weight_sq_sum) {
+  accepted_ = accepted;
+  weight_sum_ = weight_sum;
+  weight_sq_sum_ = weight_sq_sum;
+}
+
+void RunHeader::set_stopping_point(const std::string& reason, double target_precision, double precision) {
+  stop_reason_ = reason;
+  target_precision_ = target_precision;
+  precision_ = precision;
+}
+
+void RunHeader::set_truncated(Long64_t truncated) {
+  truncated_ = truncated;
+}
+
+void RunHeader::set_selection(const std::string& selection, Long64_t selected) {
+  selection_ = selection;
+  selected_ = selected;
+}
+
+void RunHeader::set_bias_function(const std::string& function) {
+  bias_function_ = function;
+}
+
+void RunHeader::set_fast_leakage(const std::string& model) {
+  fast_leakage_ = model;
+}
+
+void RunHeader::merge(const RunHeader& other) {
+  auto check = [](bool same, const std::string& what) {
+    if (not same) {
+      throw std::runtime_error("Unable to merge runs with different "+what+".");
+    }
+  };
+  check(filter_ == other.filter_ and filter_threshold_ == other.filter_threshold_, "filters");
+  check(bias_factor_ == other.bias_factor_, "bias factors");
+  check(bias_function_ == other.bias_function_, "bias functions");
+  check(fast_leakage_ == other.fast_leakage_, "fast leakage models");
+  check(brem_bias_factor_ == other.brem_bias_factor_, "brem bias factors");
+  check(target_ == other.target_, "target materials");
+  check(depth_ == other.depth_, "target depths");
+  check(selection_ == other.selection_, "selections");
+  check(beam_ == other.beam_ and photons_ == other.photons_, "beams");
+  check(version_major_ == other.version_major_ and
+        version_minor_ == other.version_minor_ and
+        version_patch_ == other.version_patch_, "versions");
+  std::vector<long> seeds{this->seeds()};
+  for (long seed : other.seeds()) {
+    if (std::find(seeds.begin(), seeds.end(), seed) != seeds.end()) {
+      throw std::runtime_error("Unable to merge runs with the same seed ("+std::to_string(seed)
+          +") since their events would be counted twice.");
+    }
+    seeds.push_back(seed);
+  }
+  merged_seeds_ = seeds;
+  tries_ += other.tries_;
+  truncated_ += other.truncated_;
+  selected_ = selected() + other.selected();
+  accepted_ += other.accepted_;
+  weight_sum_ += other.weight_sum_;
+  weight_sq_sum_ += other.weight_sq_sum_;
+  if (stop_reason_ != other.stop_reason_) stop_reason_ = "merged";
+  if (precision_ > 0. and other.precision_ > 0.) {
+    precision_ = 1./std::sqrt(1./(precision_*precision_) + 1./(other.precision_*other.precision_));
+  } else {
+    precision_ = 0.;
+  }
+}
+
+double RunHeader::eot() const {
+  if (weight_sum_ <= 0.) return 0.;
+  return accepted_/weight_sum_*tries_;
+}
+
+double RunHeader::eot_uncertainty() const {
+  if (accepted_ == 0 or weight_sum_ <= 0.) return 0.;
+  double mean{weight_sum_/accepted_};
+  double variance{std::max(0., weight_sq_sum_/accepted_ - mean*mean)};
+  // relative uncertainty on the mean weight is the relative uncertainty on the EoT
+  return eot()*std::sqrt(variance/accepted_)/mean;
+}
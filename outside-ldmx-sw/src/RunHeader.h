@@ -1,6 +1,8 @@
 #pragma once
 
 #include <optional>
+#include <string>
+#include <vector>
 
 #include "TObject.h"
 
@@ -10,7 +12,7 @@
  */
 class RunHeader {
   /// total number of events started (pre-filtering)
-  int tries_;
+  Long64_t tries_;
   /// was muon filtering activated?
   bool filter_;
   /// the filter threshold if it was active [MeV]
@@ -34,7 +36,34 @@ class RunHeader {
   int version_minor_;
   /// patch version number used to produce this run
   int version_patch_;
-  ClassDef(RunHeader, 1);
+  /// number of events accepted (passing the filter, before any selection)
+  Long64_t accepted_{0};
+  /// sum of the weights of the accepted events
+  double weight_sum_{0.};
+  /// sum of the squares of the weights of the accepted events
+  double weight_sq_sum_{0.};
+  /// biasing factor applied to brem of electrons within the target
+  /// (set to 1. if no biasing was done)
+  double brem_bias_factor_{1.};
+  /// why the run stopped (e.g. the requested number of events was reached)
+  std::string stop_reason_;
+  /// relative uncertainty on the yield the run was aiming for (0 if none)
+  double target_precision_{0.};
+  /// relative uncertainty on the yield when the run stopped
+  double precision_{0.};
+  /// the selection the accepted events had to pass to be written (empty if none)
+  std::string selection_;
+  /// number of accepted events passing the selection (-1 if written before selections)
+  Long64_t selected_{-1};
+  /// the energy-dependent muon-conversion bias function (empty if the factor was constant)
+  std::string bias_function_;
+  /// the fast leakage model replacing the low-energy shower (empty if fully simulated)
+  std::string fast_leakage_;
+  /// seeds of all of the runs merged into this one (empty if not merged)
+  std::vector<long> merged_seeds_;
+  /// number of events cut short by resource limits, not included in the tries
+  Long64_t truncated_{0};
+  ClassDef(RunHeader, 10);
  public:
   /// default constructor necessary for ROOT serialization
   RunHeader() = default;
@@ -46,15 +75,147 @@ class RunHeader {
    * @param[in] tries total number of events begun during production
    * @param[in] filter_threshold optional filter threshold
    * @param[in] bias_factor factor applied to muon-conversion within the target
+   * @param[in] brem_bias_factor factor applied to brem of electrons within the target
    */
   RunHeader(
-      int tries,
+      Long64_t tries,
       std::optional<double> filter_threshold,
       std::optional<double> bias_factor,
+      std::optional<double> brem_bias_factor,
       const std::string& target,
       double depth,
       double beam,
       bool photons,
       long seed
   );
+  /**
+   * Store the running statistics of the accepted event weights
+   *
+   * @param[in] accepted number of events accepted
+   * @param[in] weight_sum sum of the weights of the accepted events
+   * @param[in] weight_sq_sum sum of the squares of the weights of the accepted events
+   */
+  void set_weight_statistics(Long64_t accepted, double weight_sum, double weight_sq_sum);
+  /**
+   * Store why and with what precision the run stopped
+   *
+   * @param[in] reason why the run stopped
+   * @param[in] target_precision relative uncertainty on the yield aimed for (0 if none)
+   * @param[in] precision relative uncertainty on the yield when stopping
+   */
+  void set_stopping_point(const std::string& reason, double target_precision, double precision);
+  /**
+   * Store the number of events cut short by resource limits
+   *
+   * These events are dropped entirely, so they are not included
+   * in the tries or the weight statistics.
+   *
+   * @param[in] truncated number of events cut short
+   */
+  void set_truncated(Long64_t truncated);
+  /**
+   * Store the selection applied before writing the accepted events
+   *
+   * The weight statistics are from all of the accepted events,
+   * so the EoT does not depend on the selection.
+   *
+   * @param[in] selection description of the selection (empty if none)
+   * @param[in] selected number of accepted events passing the selection
+   */
+  void set_selection(const std::string& selection, Long64_t selected);
+  /**
+   * Store the energy-dependent muon-conversion bias function
+   *
+   * @param[in] function description of the bias function (empty if the factor was constant)
+   */
+  void set_bias_function(const std::string& function);
+  /**
+   * Store the fast leakage model used in place of the low-energy shower
+   *
+   * @param[in] model description of the model (empty if the shower was fully simulated)
+   */
+  void set_fast_leakage(const std::string& model);
+  /**
+   * Merge another run header into this one
+   *
+   * The counters and weight sums are added together after checking
+   * that the other run was configured the same as this one.
+   * The seed of this run header is kept and the precisions of the
+   * yields are combined assuming they are estimates of the same yield.
+   * The seeds of all of the merged runs are recorded so that runs
+   * with the same seed (i.e. the same events) are not counted twice.
+   *
+   * @throws std::runtime_error if the configuration of the runs differ
+   * or if they share a seed
+   * @param[in] other run header to merge into this one
+   */
+  void merge(const RunHeader& other);
+  /**
+   * Equivalent number of electrons (or photons) on target
+   *
+   * The average bias is the number of accepted events divided
+   * by the sum of their weights and the EoT is the number of tries
+   * scaled by this average bias.
+   */
+  double eot() const;
+  /**
+   * Statistical uncertainty on the equivalent EoT
+   *
+   * This comes from the uncertainty on the mean weight of the
+   * accepted events, calculated from the weight sums.
+   */
+  double eot_uncertainty() const;
+  /// total number of events started
+  Long64_t tries() const {
+    return tries_;
+  }
+  /// seeds of the runs merged into this one, just its own seed if not merged
+  std::vector<long> seeds() const {
+    if (merged_seeds_.empty()) return {seed_};
+    return merged_seeds_;
+  }
+  /// target material as named in G4NistManager
+  const std::string& target() const {
+    return target_;
+  }
+  /// depth of target in mm
+  double depth() const {
+    return depth_;
+  }
+  /// energy of beam in GeV
+  double beam() const {
+    return beam_;
+  }
+  /// biasing factor applied to muon-conversion, 1 if no biasing was done
+  double bias() const {
+    return bias_factor_;
+  }
+  /// the energy-dependent muon-conversion bias function, empty if the factor was constant
+  const std::string& bias_function() const {
+    return bias_function_;
+  }
+  /// the fast leakage model used, empty if the shower was fully simulated
+  const std::string& fast_leakage() const {
+    return fast_leakage_;
+  }
+  /// biasing factor applied to brem of electrons, 1 if no biasing was done
+  double brem_bias() const {
+    return brem_bias_factor_;
+  }
+  /// number of events cut short by resource limits and dropped
+  Long64_t truncated() const {
+    return truncated_;
+  }
+  /// number of events accepted
+  Long64_t accepted() const {
+    return accepted_;
+  }
+  /// number of events written, the accepted events passing the selection
+  Long64_t selected() const {
+    return selected_ < 0 ? accepted_ : selected_;
+  }
+  /// the selection applied before writing events, empty if none
+  const std::string& selection() const {
+    return selection_;
+  }
 };
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+
+/**
+ * running mean and variance of a stream of values
+ *
+ * We use Welford's algorithm so that the variance stays accurate
+ * even after many millions of values with a small spread relative
+ * to their mean.
+ */
+class RunningStatistics {
+  /// number of values
+  long unsigned int n_{0};
+  /// number of non-zero values
+  long unsigned int nonzero_{0};
+  /// mean of the values
+  double mean_{0.};
+  /// sum of squared differences from the mean
+  double m2_{0.};
+ public:
+  /// include another value
+  void add(double x) {
+    ++n_;
+    if (x != 0.) ++nonzero_;
+    double delta{x-mean_};
+    mean_ += delta/n_;
+    m2_ += delta*(x-mean_);
+  }
+  /// number of values
+  long unsigned int n() const {
+    return n_;
+  }
+  /// number of non-zero values
+  long unsigned int nonzero() const {
+    return nonzero_;
+  }
+  /// mean of the values
+  double mean() const {
+    return mean_;
+  }
+  /// unbiased sample variance of the values
+  double variance() const {
+    return n_ > 1 ? m2_/(n_-1) : 0.;
+  }
+  /// uncertainty on the mean relative to the mean, infinite if the mean is not positive
+  double relative_uncertainty() const {
+    if (mean_ <= 0.) return std::numeric_limits<double>::infinity();
+    return std::sqrt(variance()/n_)/mean_;
+  }
+};
@@ -5,6 +5,7 @@
 /*   C++ StdLib   */
 /*----------------*/
 #include <iostream>
+#include <stdexcept>
 
 /*~~~~~~~~~~~~*/
 /*   Geant4   */
@@ -15,12 +16,42 @@
 #include "G4Step.hh"
 #include "G4StepPoint.hh"
 
-ScoringPlaneSD::ScoringPlaneSD(const std::string& name, PersistParticles& persister)
-  : G4VSensitiveDetector(name), persist_{persister} {
+ScoringPlaneSD::Direction ScoringPlaneSD::direction(const std::string& name) {
+  if (name == "downstream") return Downstream;
+  if (name == "upstream") return Upstream;
+  if (name == "both") return Both;
+  throw std::runtime_error("Unknown scoring direction '"+name+"', it should be downstream, upstream, or both.");
+}
+
+ScoringPlaneSD::ScoringPlaneSD(const std::string& name, PersistParticles& persister, Direction direction)
+  : G4VSensitiveDetector(name), persist_{persister}, direction_{direction} {
   G4SDManager::GetSDMpointer()->AddNewDetector(this);
 }
 
+void ScoringPlaneSD::Initialize(G4HCofThisEvent*) {
+  scored_ = false;
+}
+
+void ScoringPlaneSD::PreUserTrackingAction(const G4Track*) {
+  scored_ = false;
+}
+
 G4bool ScoringPlaneSD::ProcessHits(G4Step* step, G4TouchableHistory*) {
+  /**
+   * only the step starting on the boundary of the plane is the
+   * particle entering it, the rest are within the plane
+   */
+  const G4StepPoint* pre{step->GetPreStepPoint()};
+  if (pre->GetStepStatus() != fGeomBoundary) return false;
+  /**
+   * the faces of the plane are perpendicular to the beam axis,
+   * so which face a particle entered through is given by the sign of
+   * its momentum along the beam axis
+   */
+  double pz{pre->GetMomentumDirection().z()};
+  if ((direction_ == Downstream and pz <= 0.) or (direction_ == Upstream and pz >= 0.)) return false;
+  if (scored_) return false;
+  scored_ = true;
   persist_.NewScoringPlaneHit(this->GetName(), step);
   return true;
 }
@@ -1,20 +1,67 @@
 #pragma once
 
+#include <string>
+
+#include "G4Track.hh"
 #include "G4VSensitiveDetector.hh"
 
 #include "PersistParticles.h"
 
 /**
  * Class defining a basic sensitive detector for scoring planes.
+ *
+ * A particle is only scored when it enters the plane through one of its
+ * faces and only the first time its track does so, so particles taking
+ * several steps within the plane or crossing it more than once are not
+ * recorded more than once. This is tracked per live track rather than per
+ * track ID since the copies made when splitting share the ID of the original
+ * and each of them should be recorded with its share of the weight.
  */
 class ScoringPlaneSD : public G4VSensitiveDetector {
  public:
+  /// which particles crossing the plane we score
+  enum Direction {
+    /// entering through the upstream face (heading away from the target)
+    Downstream,
+    /// entering through the downstream face (heading back towards the target)
+    Upstream,
+    /// entering through either face
+    Both
+  };
+
+  /**
+   * get the direction from its name
+   *
+   * @throws std::runtime_error if the name is not downstream, upstream, or both
+   * @param[in] name name of direction
+   */
+  static Direction direction(const std::string& name);
+
   /**
    * Constructor
    *
    * @param name The name of the sensitive detector.
+   * @param persist handle to the central persistence
+   * @param direction which particles crossing the plane to score
+   */
+  ScoringPlaneSD(const std::string& name, PersistParticles& persist, Direction direction = Downstream);
+
+  /**
+   * Forget whether the last track was scored
+   *
+   * Geant4 calls this at the start of every event.
+   */
+  virtual void Initialize(G4HCofThisEvent*) final override;
+
+  /**
+   * Forget whether the last track was scored
+   *
+   * Tracks are processed one at a time, so this must be called
+   * at the start of every track.
+   *
+   * @param[in] track track about to be processed
    */
-  ScoringPlaneSD(const std::string& name, PersistParticles& persist);
+  void PreUserTrackingAction(const G4Track* track);
 
   /** Destructor */
   virtual ~ScoringPlaneSD() = default;
@@ -42,5 +89,9 @@ class ScoringPlaneSD : public G4VSensitiveDetector {
  private:
   /// handle to the central persistence
   PersistParticles& persist_;
+  /// which particles crossing the plane we score
+  Direction direction_;
+  /// the track being processed has already been scored
+  bool scored_{false};
 };  // ScoringPlaneSD
 
@@ -0,0 +1,157 @@
+#include "Selection.h"
+
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <regex>
+#include <stdexcept>
+
+#include "Kinematics.h"
+
+/// a variable of the event that predicates can compare
+using Variable = std::function<double(const Particle&, const Particle&,
+    const std::vector<Particle>&, const std::vector<Particle>&)>;
+
+/// not-a-number returned by muon variables when there is no muon-conversion
+static const double NaN = std::numeric_limits<double>::quiet_NaN();
+
+/// the variables available by name
+static const std::map<std::string, Variable> VARIABLES = {
+  {"mu_max_energy", [](const Particle& p, const Particle& m, const auto&, const auto&) {
+      if (not p.is_valid() or not m.is_valid()) return NaN;
+      return std::max(p.total_energy(), m.total_energy());
+    }},
+  {"mu_min_energy", [](const Particle& p, const Particle& m, const auto&, const auto&) {
+      if (not p.is_valid() or not m.is_valid()) return NaN;
+      return std::min(p.total_energy(), m.total_energy());
+    }},
+  {"pair_mass", [](const Particle& p, const Particle& m, const auto&, const auto&) {
+      if (not p.is_valid() or not m.is_valid()) return NaN;
+      return kinematics::pair_mass(p, m);
+    }},
+  {"opening_angle", [](const Particle& p, const Particle& m, const auto&, const auto&) {
+      if (not p.is_valid() or not m.is_valid()) return NaN;
+      return kinematics::opening_angle(p, m);
+    }},
+  {"mu_max_theta", [](const Particle& p, const Particle& m, const auto&, const auto&) {
+      if (not p.is_valid() or not m.is_valid()) return NaN;
+      return std::max(p.momentum().Theta(), m.momentum().Theta());
+    }},
+  {"mu_min_theta", [](const Particle& p, const Particle& m, const auto&, const auto&) {
+      if (not p.is_valid() or not m.is_valid()) return NaN;
+      return std::min(p.momentum().Theta(), m.momentum().Theta());
+    }},
+  {"mu_max_ecal_radius", [](const Particle& p, const Particle& m, const auto&, const std::vector<Particle>& ecal) {
+      if (not p.is_valid() or not m.is_valid()) return NaN;
+      const Particle* hit_plus{kinematics::find_hit(ecal, p.id())};
+      const Particle* hit_minus{kinematics::find_hit(ecal, m.id())};
+      if (not hit_plus or not hit_minus) return std::numeric_limits<double>::infinity();
+      return std::max(kinematics::radius(*hit_plus), kinematics::radius(*hit_minus));
+    }},
+  {"mu_ecal_hits", [](const Particle& p, const Particle& m, const auto&, const std::vector<Particle>& ecal) {
+      double hits{0.};
+      for (const Particle* mu : {&p, &m}) {
+        if (mu->is_valid() and kinematics::find_hit(ecal, mu->id())) hits += 1.;
+      }
+      return hits;
+    }},
+  {"extra_energy", [](const Particle&, const Particle&, const std::vector<Particle>& extra, const auto&) {
+      double energy{0.};
+      for (const Particle& particle : extra) energy += particle.total_energy();
+      return energy;
+    }},
+  {"extra_count", [](const Particle&, const Particle&, const std::vector<Particle>& extra, const auto&) {
+      return static_cast<double>(extra.size());
+    }}
+};
+
+/// the comparisons available by symbol
+static const std::map<std::string, std::function<bool(double, double)>> COMPARISONS = {
+  {"<", std::less<double>()},
+  {"<=", std::less_equal<double>()},
+  {">", std::greater<double>()},
+  {">=", std::greater_equal<double>()},
+  {"==", std::equal_to<double>()},
+  {"!=", std::not_equal_to<double>()}
+};
+
+void Selection::add(const std::string& expression) {
+  static const std::regex separator{"\\s+and\\s+"};
+  static const std::regex predicate{"\\s*([a-z_]+)\\s*(<=|>=|==|!=|<|>)\\s*([^\\s]+)\\s*"};
+  for (std::sregex_token_iterator it{expression.begin(), expression.end(), separator, -1}, end;
+       it != end; ++it) {
+    std::string text{*it};
+    if (text.find_first_not_of(" \t") == std::string::npos) continue;
+    std::smatch match;
+    if (not std::regex_match(text, match, predicate)) {
+      throw std::runtime_error("Unable to parse selection predicate '"+text
+          +"', it should look like 'mu_min_energy > 2000'.");
+    }
+    auto variable{VARIABLES.find(match[1])};
+    if (variable == VARIABLES.end()) {
+      throw std::runtime_error("Unknown variable '"+match[1].str()+"' in selection predicate '"+text+"'.");
+    }
+    double value;
+    std::size_t parsed{0};
+    try {
+      value = std::stod(match[3], &parsed);
+    } catch (const std::logic_error&) {
+      parsed = 0;
+    }
+    if (parsed != match[3].length()) {
+      throw std::runtime_error("Unable to parse the value '"+match[3].str()+"' in selection predicate '"+text+"'.");
+    }
+    Variable var{variable->second};
+    auto compare{COMPARISONS.at(match[2])};
+    predicates_.push_back(Predicate{
+        match[1].str()+" "+match[2].str()+" "+match[3].str(),
+        [var, compare, value](const Particle& p, const Particle& m,
+            const std::vector<Particle>& extra, const std::vector<Particle>& ecal) {
+          // NaN != value would be true, but every comparison with a missing variable fails
+          double x{var(p, m, extra, ecal)};
+          return not std::isnan(x) and compare(x, value);
+        }
+    });
+    rejected_.push_back(0);
+  }
+}
+
+void Selection::add_file(const std::string& filepath) {
+  std::ifstream f{filepath};
+  if (not f.is_open()) {
+    throw std::runtime_error("Unable to open selection file '"+filepath+"'.");
+  }
+  std::string line;
+  while (std::getline(f, line)) {
+    add(line.substr(0, line.find('#')));
+  }
+}
+
+bool Selection::pass(const Particle& mu_plus, const Particle& mu_minus,
+    const std::vector<Particle>& extra, const std::vector<Particle>& ecal) {
+  for (std::size_t i{0}; i < predicates_.size(); ++i) {
+    if (not predicates_[i].pass(mu_plus, mu_minus, extra, ecal)) {
+      ++rejected_[i];
+      return false;
+    }
+  }
+  return true;
+}
+
+std::string Selection::description() const {
+  std::string d;
+  for (const Predicate& p : predicates_) {
+    if (not d.empty()) d += " and ";
+    d += p.description;
+  }
+  return d;
+}
+
+void Selection::print(std::ostream& o) const {
+  o << "[ dimuon-simulate ]: Events rejected by the selection";
+  for (std::size_t i{0}; i < predicates_.size(); ++i) {
+    o << ", " << predicates_[i].description << ": " << rejected_[i];
+  }
+  o << std::endl;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "Particle.h"
+
+/**
+ * a selection of events made of predicates that must all be passed
+ *
+ * Each predicate compares a variable of the event to a number,
+ * for example `mu_min_energy > 2000` or `mu_ecal_hits == 2`.
+ * The comparisons can be any of <, <=, >, >=, ==, and !=.
+ *
+ * Variables
+ * - mu_max_energy : maximum total energy of the two muons [MeV]
+ * - mu_min_energy : minimum total energy of the two muons [MeV]
+ * - pair_mass : invariant mass of the two muons [MeV]
+ * - opening_angle : angle between the two muons [rad]
+ * - mu_max_theta : maximum polar angle of the two muons [rad]
+ * - mu_min_theta : minimum polar angle of the two muons [rad]
+ * - mu_max_ecal_radius : maximum distance from the beam axis of the two muons
+ *   at the ECal scoring plane [mm], infinite if either muon misses the plane
+ * - mu_ecal_hits : number of muons reaching the ECal scoring plane
+ * - extra_energy : total energy of the extra particles leaving the target [MeV]
+ * - extra_count : number of extra particles leaving the target
+ *
+ * The muon variables are NaN if the event does not have a muon-conversion,
+ * so any comparison with them (including !=) fails.
+ */
+class Selection {
+  /// a single predicate
+  struct Predicate {
+    /// the predicate as written, used for printing and recording
+    std::string description;
+    /// evaluate the predicate on the event
+    std::function<bool(const Particle&, const Particle&,
+        const std::vector<Particle>&, const std::vector<Particle>&)> pass;
+  };
+  /// the predicates that must all be passed
+  std::vector<Predicate> predicates_;
+  /// number of events rejected by each predicate (the first one they fail)
+  std::vector<long unsigned int> rejected_;
+ public:
+  /// an empty selection which passes every event
+  Selection() = default;
+
+  /**
+   * Add predicates to the selection
+   *
+   * Multiple predicates can be separated by 'and'.
+   *
+   * @throws std::runtime_error if a predicate cannot be parsed
+   * @param[in] expression one or more predicates
+   */
+  void add(const std::string& expression);
+
+  /**
+   * Add the predicates in a file to the selection
+   *
+   * Each line is given to add and anything after a '#' is ignored.
+   *
+   * @throws std::runtime_error if the file cannot be opened or a predicate cannot be parsed
+   * @param[in] filepath path to file of predicates
+   */
+  void add_file(const std::string& filepath);
+
+  /// check if any predicates have been added
+  bool empty() const {
+    return predicates_.empty();
+  }
+
+  /**
+   * Check if an event passes all of the predicates, counting it if it doesn't
+   *
+   * @param[in] mu_plus outgoing mu+
+   * @param[in] mu_minus outgoing mu-
+   * @param[in] extra other particles leaving the target
+   * @param[in] ecal particles entering the ECal
+   * @return true if the event passes
+   */
+  bool pass(const Particle& mu_plus, const Particle& mu_minus,
+      const std::vector<Particle>& extra, const std::vector<Particle>& ecal);
+
+  /// the predicates joined by 'and', empty if there are none
+  std::string description() const;
+
+  /// print the number of events rejected by each predicate
+  void print(std::ostream& o) const;
+};
@@ -0,0 +1,84 @@
+#include "StepProfiler.h"
+
+#include <algorithm>
+#include <iomanip>
+#include <vector>
+
+#include "G4VProcess.hh"
+
+void StepProfiler::PreUserTrackingAction(const G4Track*) {
+  last_ = std::chrono::steady_clock::now();
+}
+
+void StepProfiler::UserSteppingAction(const G4Step* step) {
+  auto now{std::chrono::steady_clock::now()};
+  std::chrono::duration<double> elapsed{now-last_};
+  last_ = now;
+
+  Key key{
+    step->GetTrack()->GetParticleDefinition()->GetPDGEncoding(),
+    step->GetPreStepPoint()->GetPhysicalVolume(),
+    step->GetPostStepPoint()->GetProcessDefinedStep()
+  };
+  if (last_entry_ == nullptr or not (key == last_key_)) {
+    auto [it, inserted] = table_.try_emplace(key);
+    if (inserted) {
+      it->second.volume = key.volume ? key.volume->GetName() : "none";
+      it->second.process = key.process ? key.process->GetProcessName() : "none";
+    }
+    last_key_ = key;
+    // references to the entries of an unordered_map survive rehashing
+    last_entry_ = &it->second;
+  }
+  last_entry_->steps++;
+  last_entry_->time += elapsed.count();
+}
+
+std::unique_ptr<TTree> StepProfiler::tree() const {
+  auto t{std::make_unique<TTree>("step_profile", "Steps by Particle, Volume, and Process")};
+  // we own the tree, not whatever ROOT directory happens to be open
+  t->SetDirectory(nullptr);
+  int pdg;
+  std::string volume, process;
+  Long64_t steps;
+  double time;
+  t->Branch("pdg", &pdg);
+  t->Branch("volume", &volume);
+  t->Branch("process", &process);
+  t->Branch("steps", &steps);
+  t->Branch("time", &time);
+  for (const auto& [key, entry] : table_) {
+    pdg = key.pdg;
+    volume = entry.volume;
+    process = entry.process;
+    steps = entry.steps;
+    time = entry.time;
+    t->Fill();
+  }
+  t->ResetBranchAddresses();
+  return t;
+}
+
+void StepProfiler::print(std::ostream& o, std::size_t n) const {
+  std::vector<std::pair<Key, const Entry*>> entries;
+  long unsigned int total_steps{0};
+  double total_time{0.};
+  for (const auto& [key, entry] : table_) {
+    entries.emplace_back(key, &entry);
+    total_steps += entry.steps;
+    total_time += entry.time;
+  }
+  std::sort(entries.begin(), entries.end(), [](const auto& a, const auto& b) {
+    return a.second->time > b.second->time;
+  });
+  o << "[ dimuon-simulate ]: " << total_steps << " steps took " << total_time << "s, the most expensive were\n"
+    << std::setw(12) << "pdg" << std::setw(12) << "volume" << std::setw(20) << "process"
+    << std::setw(14) << "steps" << std::setw(12) << "time [s]" << std::setw(10) << "time [%]" << "\n";
+  for (std::size_t i{0}; i < entries.size() and i < n; ++i) {
+    const auto& [key, entry] = entries[i];
+    o << std::setw(12) << key.pdg << std::setw(12) << entry->volume << std::setw(20) << entry->process
+      << std::setw(14) << entry->steps << std::setw(12) << entry->time
+      << std::setw(10) << (total_time > 0. ? 100.*entry->time/total_time : 0.) << "\n";
+  }
+  o << std::flush;
+}
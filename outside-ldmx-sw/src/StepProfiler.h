@@ -0,0 +1,103 @@
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+
+#include "G4Step.hh"
+#include "G4Track.hh"
+
+#include "TTree.h"
+
+/**
+ * profile which particles, volumes, and processes the steps are spent on
+ *
+ * Each step is counted against the PDG ID of its particle, the volume
+ * it started in, and the process that limited it, along with the wall time
+ * it took. The time of a step is measured from the end of the previous step
+ * of the same track (or the start of the track) so it includes the transport,
+ * the physics, and the user actions of the step.
+ *
+ * The table is kept in memory for the whole run and is small since there
+ * are only a handful of volumes and a few dozen processes. The last entry
+ * is remembered so that the consecutive steps of a track with the same
+ * key do not need to look it up again.
+ */
+class StepProfiler {
+  /// what a step is counted against
+  struct Key {
+    /// PDG ID of the particle
+    int pdg;
+    /// volume the step started in
+    const G4VPhysicalVolume* volume;
+    /// process that limited the step
+    const G4VProcess* process;
+    bool operator==(const Key& other) const {
+      return pdg == other.pdg and volume == other.volume and process == other.process;
+    }
+  };
+  /// hash of the key for the table
+  struct KeyHash {
+    std::size_t operator()(const Key& key) const {
+      std::size_t h{std::hash<int>()(key.pdg)};
+      h ^= std::hash<const void*>()(key.volume) + 0x9e3779b9 + (h << 6) + (h >> 2);
+      h ^= std::hash<const void*>()(key.process) + 0x9e3779b9 + (h << 6) + (h >> 2);
+      return h;
+    }
+  };
+  /// the accumulated steps of a key
+  struct Entry {
+    /// name of the volume, looked up once when the entry is created
+    std::string volume;
+    /// name of the process, looked up once when the entry is created
+    std::string process;
+    /// number of steps
+    long unsigned int steps{0};
+    /// total wall time of the steps [s]
+    double time{0.};
+  };
+  /// the table of entries
+  std::unordered_map<Key, Entry, KeyHash> table_;
+  /// the last key counted against
+  Key last_key_{0, nullptr, nullptr};
+  /// the last entry counted against, null before the first step
+  Entry* last_entry_{nullptr};
+  /// when the last step of the current track ended
+  std::chrono::steady_clock::time_point last_;
+ public:
+  /**
+   * Start timing the first step of the track
+   *
+   * @param[in] track unused
+   */
+  void PreUserTrackingAction(const G4Track* track);
+
+  /**
+   * Count the step and its time against its key
+   *
+   * This should be called after the other stepping actions so that
+   * their time is included in the step that called them.
+   *
+   * @param[in] step current step being processed
+   */
+  void UserSteppingAction(const G4Step* step);
+
+  /**
+   * Build a tree from the table so it can be written to the output file
+   *
+   * The tree has one entry per key with the branches pdg, volume,
+   * process, steps, and time [s].
+   */
+  std::unique_ptr<TTree> tree() const;
+
+  /**
+   * Print the keys taking the most time
+   *
+   * @param[in] o stream to print to
+   * @param[in] n maximum number of keys to print
+   */
+  void print(std::ostream& o, std::size_t n = 20) const;
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Running our executables as child processes
+ *
+ * The tools that drive many runs of dimuon-simulate launch each run
+ * as its own process so that a crash of one run does not lose the others
+ * and so that the kernel can tell us the resources each run used.
+ */
+namespace subprocess {
+
+/// the result of a finished child process
+struct Result {
+  /// process ID of the child
+  pid_t pid{-1};
+  /// exit code of the child, or 128 plus the signal that killed it
+  int exit_code{-1};
+  /// peak resident set size of the child [kB]
+  long max_rss{0};
+  /// user CPU time of the child [s]
+  double user_time{0.};
+  /// system CPU time of the child [s]
+  double system_time{0.};
+};
+
+/**
+ * path to an executable installed next to the running one
+ *
+ * @param[in] name name of the other executable
+ * @return path to the other executable in the same directory as this one
+ */
+inline std::string sibling(const std::string& name) {
+  return (std::filesystem::read_symlink("/proc/self/exe").parent_path() / name).string();
+}
+
+/**
+ * start a child process
+ *
+ * @param[in] args command to run, the first argument is the executable
+ * @param[in] log file to redirect the output of the child into
+ * @return process ID of the child
+ */
+inline pid_t spawn(const std::vector<std::string>& args, const std::string& log = "/dev/null") {
+  if (args.empty()) {
+    throw std::runtime_error("No command given to run.");
+  }
+  pid_t pid = fork();
+  if (pid < 0) {
+    throw std::runtime_error("Unable to fork to run '"+args[0]+"'.");
+  }
+  if (pid == 0) {
+    int fd = open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd >= 0) {
+      dup2(fd, STDOUT_FILENO);
+      dup2(fd, STDERR_FILENO);
+      close(fd);
+    }
+    std::vector<char*> argv;
+    for (const std::string& arg : args) argv.push_back(const_cast<char*>(arg.c_str()));
+    argv.push_back(nullptr);
+    execv(argv[0], argv.data());
+    // only get here if the exec failed
+    _exit(126);
+  }
+  return pid;
+}
+
+/**
+ * wait for a child process to finish
+ *
+ * @param[in] pid process ID of the child to wait for, -1 waits for any child
+ * @return the result of the child that finished
+ */
+inline Result wait(pid_t pid = -1) {
+  int status{0};
+  struct rusage usage{};
+  Result result;
+  result.pid = wait4(pid, &status, 0, &usage);
+  if (result.pid < 0) {
+    throw std::runtime_error("No child process to wait for.");
+  }
+  if (WIFEXITED(status)) result.exit_code = WEXITSTATUS(status);
+  else if (WIFSIGNALED(status)) result.exit_code = 128+WTERMSIG(status);
+  result.max_rss = usage.ru_maxrss;
+  result.user_time = usage.ru_utime.tv_sec + usage.ru_utime.tv_usec/1e6;
+  result.system_time = usage.ru_stime.tv_sec + usage.ru_stime.tv_usec/1e6;
+  return result;
+}
+
+/**
+ * run a child process to completion
+ *
+ * @param[in] args command to run, the first argument is the executable
+ * @param[in] log file to redirect the output of the child into
+ * @return the result of the child
+ */
+inline Result run(const std::vector<std::string>& args, const std::string& log = "/dev/null") {
+  return wait(spawn(args, log));
+}
+
+}  // namespace subprocess
@@ -0,0 +1,87 @@
+#include "Telemetry.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+
+#include "Memory.h"
+
+Telemetry::Telemetry(const std::string& filepath, double period, long unsigned int requested)
+  : filepath_{filepath},
+    prometheus_{filepath.size() >= 5 and filepath.compare(filepath.size()-5, 5, ".prom") == 0},
+    period_{period},
+    requested_{requested},
+    start_{std::chrono::steady_clock::now()},
+    last_write_{start_} {
+  write(0, 0, 0., false);
+}
+
+void Telemetry::update(long unsigned int started, long unsigned int completed, double weight_sum) {
+  if (std::chrono::steady_clock::now()-last_write_ < period_) return;
+  // a hiccup in the file system should not take down the simulation
+  try {
+    write(started, completed, weight_sum, false);
+  } catch (const std::exception& e) {
+    std::cerr << "[ dimuon-simulate ]: WARNING " << e.what() << std::endl;
+  }
+}
+
+void Telemetry::finish(long unsigned int started, long unsigned int completed, double weight_sum) {
+  try {
+    write(started, completed, weight_sum, true);
+  } catch (const std::exception& e) {
+    std::cerr << "[ dimuon-simulate ]: WARNING " << e.what() << std::endl;
+  }
+}
+
+void Telemetry::write(long unsigned int started, long unsigned int completed, double weight_sum, bool done) {
+  last_write_ = std::chrono::steady_clock::now();
+  double elapsed{std::chrono::duration<double>(last_write_-start_).count()};
+  double rate{elapsed > 0. ? started/elapsed : 0.};
+  double acceptance{started > 0 ? static_cast<double>(completed)/started : 0.};
+  double mean_weight{completed > 0 ? weight_sum/completed : 0.};
+  double eta{done ? 0. : (rate > 0. and requested_ > started ? (requested_-started)/rate : -1.)};
+  double rss{memory::resident_set_size()};
+
+  std::string tmp{filepath_+".tmp"};
+  {
+    std::ofstream f{tmp};
+    if (not f.is_open()) {
+      throw std::runtime_error("Unable to open telemetry file '"+tmp+"' for writing.");
+    }
+    if (prometheus_) {
+      auto metric = [&f](const std::string& name, const std::string& help, double value) {
+        f << "# HELP dimuon_simulate_" << name << " " << help << "\n"
+          << "# TYPE dimuon_simulate_" << name << " gauge\n"
+          << "dimuon_simulate_" << name << " " << value << "\n";
+      };
+      metric("events_requested", "Number of events requested.", requested_);
+      metric("events_started", "Number of events started.", started);
+      metric("events_completed", "Number of events kept.", completed);
+      metric("acceptance", "Fraction of started events that were kept.", acceptance);
+      metric("events_per_second", "Events started per second of wall time.", rate);
+      metric("mean_weight", "Mean weight of the kept events.", mean_weight);
+      metric("eta_seconds", "Estimated seconds until the requested events are started, -1 if unknown.", eta);
+      metric("rss_megabytes", "Resident memory of the process in MB.", rss);
+      metric("elapsed_seconds", "Seconds of wall time since the run started.", elapsed);
+      metric("done", "1 if the run has finished.", done);
+    } else {
+      f << "{\n"
+        << "  \"events_requested\": " << requested_ << ",\n"
+        << "  \"events_started\": " << started << ",\n"
+        << "  \"events_completed\": " << completed << ",\n"
+        << "  \"acceptance\": " << acceptance << ",\n"
+        << "  \"events_per_second\": " << rate << ",\n"
+        << "  \"mean_weight\": " << mean_weight << ",\n"
+        << "  \"eta_seconds\": " << eta << ",\n"
+        << "  \"rss_megabytes\": " << rss << ",\n"
+        << "  \"elapsed_seconds\": " << elapsed << ",\n"
+        << "  \"done\": " << (done ? "true" : "false") << "\n"
+        << "}\n";
+    }
+  }
+  if (std::rename(tmp.c_str(), filepath_.c_str()) != 0) {
+    throw std::runtime_error("Unable to move telemetry into '"+filepath_+"'.");
+  }
+}
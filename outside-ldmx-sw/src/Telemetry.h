@@ -0,0 +1,61 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+/**
+ * periodically publish the progress of the run to a small metrics file
+ *
+ * The file is rewritten at most once per period by writing a temporary
+ * file next to it and renaming it into place, so readers never see a
+ * partially written file. If the file name ends in ".prom", it is written
+ * in the Prometheus text exposition format (e.g. for the textfile collector
+ * of node_exporter), otherwise it is written as JSON.
+ */
+class Telemetry {
+  /// the file to publish to
+  std::string filepath_;
+  /// true if we are writing the Prometheus format
+  bool prometheus_;
+  /// minimum time between writes
+  std::chrono::duration<double> period_;
+  /// number of events requested
+  long unsigned int requested_;
+  /// wall time when the run started
+  std::chrono::steady_clock::time_point start_;
+  /// wall time of the last write
+  std::chrono::steady_clock::time_point last_write_;
+  /// write the metrics to the file
+  void write(long unsigned int started, long unsigned int completed, double weight_sum, bool done);
+ public:
+  /**
+   * Configure where and how often to publish
+   *
+   * An initial write is done so that a bad file path is found before
+   * any events are simulated.
+   *
+   * @throws std::runtime_error if the file cannot be written
+   * @param[in] filepath file to publish to
+   * @param[in] period minimum number of seconds between writes
+   * @param[in] requested number of events requested
+   */
+  Telemetry(const std::string& filepath, double period, long unsigned int requested);
+
+  /**
+   * Publish the progress if the period has passed since the last write
+   *
+   * @param[in] started number of events started
+   * @param[in] completed number of events kept
+   * @param[in] weight_sum sum of the weights of the kept events
+   */
+  void update(long unsigned int started, long unsigned int completed, double weight_sum);
+
+  /**
+   * Publish the final progress regardless of the period
+   *
+   * @param[in] started number of events started
+   * @param[in] completed number of events kept
+   * @param[in] weight_sum sum of the weights of the kept events
+   */
+  void finish(long unsigned int started, long unsigned int completed, double weight_sum);
+};
@@ -0,0 +1,91 @@
+#include "TrackCulling.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include "Hunk.h"
+
+const std::array<std::string, TrackCulling::NumCategories> TrackCulling::NAMES = {
+  "past-ecal",
+  "backsplash",
+  "no-path"
+};
+
+TrackCulling::TrackCulling(double depth, const std::string& categories)
+  : depth_{depth},
+    killed_{"culled_tracks", "Tracks Killed in the World;Category;Tracks",
+      NumCategories, 0., static_cast<double>(NumCategories)} {
+  // we own the histogram, not whatever ROOT directory happens to be open
+  killed_.SetDirectory(nullptr);
+  for (int i{0}; i < NumCategories; ++i) killed_.GetXaxis()->SetBinLabel(i+1, NAMES[i].c_str());
+
+  std::stringstream ss{categories};
+  std::string name;
+  while (std::getline(ss, name, ',')) {
+    if (name == "all") {
+      enabled_.fill(true);
+      continue;
+    }
+    bool found{false};
+    for (int i{0}; i < NumCategories; ++i) {
+      if (name == NAMES[i]) {
+        enabled_[i] = true;
+        found = true;
+      }
+    }
+    if (not found) {
+      throw std::runtime_error("Unknown track culling category '"+name+"'.");
+    }
+  }
+}
+
+bool TrackCulling::hits(const G4ThreeVector& point, const G4ThreeVector& direction,
+    double z_min, double z_max) {
+  // slab method: intersect the ranges of the line parameter within each pair of faces
+  const double lower[3] = {-Hunk::HALF_WIDTH, -Hunk::HALF_WIDTH, z_min},
+               upper[3] = {Hunk::HALF_WIDTH, Hunk::HALF_WIDTH, z_max};
+  double t_min{0.}, t_max{std::numeric_limits<double>::infinity()};
+  for (int i{0}; i < 3; ++i) {
+    if (direction[i] == 0.) {
+      if (point[i] < lower[i] or point[i] > upper[i]) return false;
+      continue;
+    }
+    double t_lower{(lower[i]-point[i])/direction[i]},
+           t_upper{(upper[i]-point[i])/direction[i]};
+    if (t_lower > t_upper) std::swap(t_lower, t_upper);
+    t_min = std::max(t_min, t_lower);
+    t_max = std::min(t_max, t_upper);
+    if (t_min > t_max) return false;
+  }
+  return true;
+}
+
+void TrackCulling::UserSteppingAction(const G4Step* step) {
+  const G4StepPoint* post{step->GetPostStepPoint()};
+  const G4VPhysicalVolume* volume{post->GetPhysicalVolume()};
+  // leaving the world or still within the hunk or plane
+  if (volume == nullptr or volume->GetName() != "World") return;
+  G4Track* track{step->GetTrack()};
+  if (track->GetTrackStatus() == fStopAndKill) return;
+
+  const G4ThreeVector& position{post->GetPosition()};
+  const G4ThreeVector& direction{post->GetMomentumDirection()};
+  const double plane_front{Hunk::ECAL_SP_Z-Hunk::ECAL_SP_HALF_THICKNESS},
+               plane_back{Hunk::ECAL_SP_Z+Hunk::ECAL_SP_HALF_THICKNESS};
+  Category category;
+  if (position.z() >= plane_back) {
+    category = PastEcal;
+  } else if (position.z() <= -depth_ and direction.z() <= 0.) {
+    category = Backsplash;
+  } else if (not hits(position, direction, -depth_, 0.) and
+             not hits(position, direction, plane_front, plane_back)) {
+    category = NoPath;
+  } else {
+    return;
+  }
+  if (not enabled_[category]) return;
+  killed_.Fill(category);
+  track->SetTrackStatus(fStopAndKill);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <array>
+#include <string>
+
+#include "G4Step.hh"
+
+#include "TH1D.h"
+
+/**
+ * kill tracks in the air of the world that cannot affect what we record
+ *
+ * We only record the particles leaving the hunk and the particles crossing
+ * the ECal scoring plane, but Geant4 keeps transporting every track through
+ * the air until it leaves the world. Particles travel in straight lines through
+ * the air (there is no magnetic field), so after each step in the world we check
+ * if the track can still reach the hunk or the plane and kill it if it can't.
+ *
+ * The categories of tracks that can be killed are
+ * - past-ecal : tracks that are past the ECal scoring plane
+ * - backsplash : tracks that are upstream of the hunk and heading upstream
+ * - no-path : any other track in the world whose straight line misses both the
+ *   hunk and the ECal scoring plane (e.g. tracks heading sideways)
+ */
+class TrackCulling {
+ public:
+  /// the categories of tracks we kill
+  enum Category {
+    PastEcal = 0,
+    Backsplash,
+    NoPath,
+    NumCategories
+  };
+  /// names of the categories used for configuration and accounting
+  static const std::array<std::string, NumCategories> NAMES;
+ private:
+  /// depth of hunk along beam direction [mm]
+  double depth_;
+  /// which categories are enabled
+  std::array<bool, NumCategories> enabled_{};
+  /// number of tracks killed in each category
+  TH1D killed_;
+  /// check if a straight line from the input point leads into the input box
+  static bool hits(const G4ThreeVector& point, const G4ThreeVector& direction,
+      double z_min, double z_max);
+ public:
+  /**
+   * Configure which categories to kill
+   *
+   * @throws std::runtime_error if a category is not one of the known names
+   * @param[in] depth thickness of the hunk in mm
+   * @param[in] categories comma-separated list of category names, or "all"
+   */
+  TrackCulling(double depth, const std::string& categories);
+
+  /**
+   * Kill the track if it is in the world and in an enabled category
+   *
+   * This should be called after the other stepping actions so that they
+   * still see the step that took the track into the category.
+   *
+   * @param[in] step current step being processed
+   */
+  void UserSteppingAction(const G4Step* step);
+
+  /**
+   * Get the number of tracks killed in each category
+   * so it can be written to the output file
+   */
+  const TH1D& killed() const {
+    return killed_;
+  }
+};
@@ -0,0 +1,98 @@
+#include "WeightWindow.h"
+
+#include <cmath>
+#include <stdexcept>
+#include <string>
+
+#include "G4DynamicParticle.hh"
+#include "G4Electron.hh"
+#include "G4EventManager.hh"
+#include "G4Gamma.hh"
+#include "G4Positron.hh"
+#include "G4StackManager.hh"
+#include "Randomize.hh"
+
+/// ratio of the upper bound of the window to the target weight and of the target weight to the lower bound
+static const double WINDOW_WIDTH = 2.;
+
+WeightWindow::WeightWindow(double max_energy, double survival, unsigned int split, double depth)
+  : max_energy_{max_energy}, survival_{survival}, split_{split}, depth_{depth} {
+  if (survival_ <= 0. or survival_ > 1.) {
+    throw std::runtime_error("The roulette survival probability must be in (0, 1].");
+  }
+  if (split_ < 1) {
+    throw std::runtime_error("The number of copies to split into must be at least one.");
+  }
+}
+
+WeightWindow::~WeightWindow() {
+  std::cout
+    << "[ dimuon-simulate ]: Roulette killed " << killed_
+    << " tracks and kept " << survived_ << ", split " << split_tracks_ << " tracks into "
+    << copies_ << " copies."
+    << std::endl;
+}
+
+bool WeightWindow::ClassifyNewTrack(const G4Track* track) {
+  if (pushing_copies_) return false;
+  // tracks that have already been stepped are being re-classified after suspension
+  if (track->GetCurrentStepNumber() > 0) return false;
+  // leave the primary alone
+  if (track->GetParentID() == 0) return false;
+  const G4ParticleDefinition* def{track->GetDefinition()};
+  if (def != G4Gamma::Gamma() and def != G4Electron::Electron() and def != G4Positron::Positron()) {
+    return false;
+  }
+  if (track->GetKineticEnergy() >= max_energy_) return false;
+  double z{track->GetPosition().z()};
+  if (z < -depth_ or z > 0.) return false;
+
+  // Geant4 only gives us a const track, but its weight is ours to manage until it is stacked
+  G4Track* mutable_track{const_cast<G4Track*>(track)};
+  double weight{track->GetWeight()};
+  double target{track->GetMomentumDirection().z() > 0. ? 1./split_ : 1./survival_};
+
+  if (weight > WINDOW_WIDTH*target) {
+    unsigned int n_copies = static_cast<unsigned int>(std::lround(weight/target));
+    /**
+     * the heaviest track in the window is a survivor of the roulette
+     * just below the upper bound, so anything more means the weights
+     * are no longer bounded and the copies would grow without limit
+     */
+    unsigned int max_copies = static_cast<unsigned int>(std::ceil(WINDOW_WIDTH*split_/survival_));
+    if (n_copies > max_copies) {
+      throw std::runtime_error("Track with weight "+std::to_string(weight)+" would be split into "
+          +std::to_string(n_copies)+" copies, more than the "+std::to_string(max_copies)+" the window allows.");
+    }
+    ++split_tracks_;
+    copies_ += n_copies;
+    mutable_track->SetWeight(weight/n_copies);
+    pushing_copies_ = true;
+    G4StackManager* stack{G4EventManager::GetEventManager()->GetStackManager()};
+    for (unsigned int i_copy{1}; i_copy < n_copies; ++i_copy) {
+      // the copies share the track ID of the original, they are indistinguishable in the output
+      auto copy = new G4Track(
+          new G4DynamicParticle(*track->GetDynamicParticle()),
+          track->GetGlobalTime(),
+          track->GetPosition());
+      copy->SetTrackID(track->GetTrackID());
+      copy->SetParentID(track->GetParentID());
+      copy->SetCreatorProcess(track->GetCreatorProcess());
+      copy->SetTouchableHandle(track->GetTouchableHandle());
+      copy->SetWeight(weight/n_copies);
+      stack->PushOneTrack(copy);
+    }
+    pushing_copies_ = false;
+    return false;
+  }
+
+  if (weight < target/WINDOW_WIDTH) {
+    if (G4UniformRand() >= weight/target) {
+      ++killed_;
+      return true;
+    }
+    ++survived_;
+    mutable_track->SetWeight(target);
+  }
+  return false;
+}
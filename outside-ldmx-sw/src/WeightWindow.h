@@ -0,0 +1,80 @@
+#pragma once
+
+#include "G4Track.hh"
+
+/**
+ * variance reduction for the low-energy shower within the hunk
+ *
+ * New electrons, positrons, and photons produced within the hunk below
+ * an energy threshold are the bulk of the transported tracks in an
+ * inclusive run but rarely leave the target. Each of them is given a
+ * target weight depending on its direction: those heading upstream
+ * are unimportant and have a target weight of one over the survival
+ * probability while those heading downstream (towards the ECal scoring
+ * plane) have a target weight of one over the number of copies to split into.
+ *
+ * The weight of the track is then compared to a window around its target
+ * weight. Tracks heavier than the window are split into copies that share
+ * its weight and tracks lighter than the window undergo Russian roulette,
+ * surviving with the ratio of their weight to the target weight and taking
+ * the target weight if they do. Tracks within the window are left alone,
+ * so secondaries inheriting the weight of a track that was already
+ * rouletted or split are not rouletted or split again in the same direction.
+ *
+ * Every track in the window has a weight of at least half of the smallest
+ * target weight, so the number of tracks stays bounded by the weight of the
+ * shower rather than growing with each generation.
+ *
+ * The weights are carried by the tracks (and inherited by their secondaries)
+ * so the particles leaving the target must be counted with their track weights.
+ * Since these weights are not step weights, they do not enter the event weight.
+ */
+class WeightWindow {
+  /// kinetic energy below which tracks are rouletted or split [MeV]
+  double max_energy_;
+  /// probability that an unweighted track heading upstream survives
+  double survival_;
+  /// number of copies to split unweighted tracks heading downstream into
+  unsigned int split_;
+  /// depth of hunk along beam direction [mm]
+  double depth_;
+  /// true while we are pushing copies of a split track
+  bool pushing_copies_{false};
+  /// number of tracks killed by the roulette
+  long unsigned int killed_{0};
+  /// number of tracks that survived the roulette
+  long unsigned int survived_{0};
+  /// number of tracks that were split
+  long unsigned int split_tracks_{0};
+  /// number of copies made by splitting (including the originals)
+  long unsigned int copies_{0};
+ public:
+  /**
+   * Configure the window
+   *
+   * @param[in] max_energy kinetic energy below which tracks are rouletted or split in MeV
+   * @param[in] survival probability that an unweighted track heading upstream survives
+   * @param[in] split number of copies to split unweighted tracks heading downstream into,
+   * 1 only splits tracks heavier than one
+   * @param[in] depth thickness of the hunk in mm
+   */
+  WeightWindow(double max_energy, double survival, unsigned int split, double depth);
+
+  /**
+   * Print out how many tracks were rouletted and split
+   */
+  ~WeightWindow();
+
+  /**
+   * Roulette or split a new track if it is outside the window
+   *
+   * Copies of a split track are pushed directly onto the stack and will
+   * be classified again, so they are let through untouched.
+   *
+   * @throws std::runtime_error if a track would be split into more copies
+   * than the window allows, which would mean the weights are not bounded
+   * @param[in] track new track to check
+   * @return true if the track was killed by the roulette
+   */
+  bool ClassifyNewTrack(const G4Track* track);
+};